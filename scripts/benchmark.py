@@ -0,0 +1,157 @@
+"""
+Scaling benchmark of build/IC and regression check against a baseline.
+
+Runs build/IC for each (r, n) of the matrix, number of threads and output mode
+(stdout, --file, --compressed-file), and records the wall time, CPU time, peak
+RSS and throughput (matroids per second) of the fastest of the repetitions,
+with the strong-scaling efficiency relative to the fewest threads. The results
+are written as JSON. With a baseline (the results of an earlier run), runs
+whose wall time exceeds the baseline by more than the tolerance are reported
+and the exit code is 1. A baseline of another host or number of CPUs is not
+comparable and also gives exit code 1, unless --any-host is given.
+
+Usage:
+    python3 scripts/benchmark.py [--matrix 4,8 4,9] [--threads 1 2 4]
+        [--modes stdout file compressed-file] [--repeat <k>]
+        [--output <file>] [--baseline <file>] [--tolerance <fraction>]
+        [--save-baseline] [--any-host]
+"""
+from pathlib import Path
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+
+ROOT = Path(__file__).resolve().parents[1]
+IC = ROOT / 'build' / 'IC'
+MODES = {'stdout': [], 'file': ['--file'],
+         'compressed-file': ['--compressed-file']}
+
+
+def run(r, n, threads, mode, count_lines=False):
+    """Run IC once; returns wall and CPU seconds, peak RSS in bytes and, if
+    count_lines, the number of matroids written to stdout"""
+    command = [str(IC), str(r), str(n), str(threads)] + MODES[mode]
+    start = time.perf_counter()
+    proc = subprocess.Popen(command, stderr=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE if count_lines
+                            else subprocess.DEVNULL)
+    lines = sum(1 for _ in proc.stdout) if count_lines else None
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        sys.exit(f'{" ".join(command)} failed with code {proc.returncode}')
+    return {'wall_seconds': wall,
+            'cpu_seconds': usage.ru_utime + usage.ru_stime,
+            'peak_rss_bytes': usage.ru_maxrss * 1024,
+            'matroids': lines}
+
+
+def benchmark(args):
+    results = []
+    for r, n in args.matrix:
+        # Warm-up run, which also counts the matroids
+        matroids = run(r, n, args.threads[0], 'stdout', True)['matroids']
+        for mode in args.modes:
+            for threads in args.threads:
+                best = min((run(r, n, threads, mode)
+                            for _ in range(args.repeat)),
+                           key=lambda m: m['wall_seconds'])
+                best['matroids'] = matroids
+                best['matroids_per_second'] = matroids / best['wall_seconds']
+                results.append({'r': r, 'n': n, 'threads': threads,
+                                'mode': mode, **best})
+                print(f'({r}, {n}) {mode:>15} {threads:>3} thread(s): '
+                      f'{best["wall_seconds"]:8.3f} s', file=sys.stderr)
+
+    # Strong scaling: speedup over the fewest threads, per their ratio
+    for res in results:
+        first = next(s for s in results
+                     if (s['r'], s['n'], s['mode'], s['threads']) ==
+                     (res['r'], res['n'], res['mode'], args.threads[0]))
+        speedup = first['wall_seconds'] / res['wall_seconds']
+        res['efficiency'] = speedup * args.threads[0] / res['threads']
+    return results
+
+
+def key(res):
+    return res['r'], res['n'], res['threads'], res['mode']
+
+
+def regressions(results, baseline, tolerance):
+    """Runs slower than in the baseline by more than the tolerance"""
+    before = {key(res): res for res in baseline['results']}
+    slower = []
+    for res in results:
+        old = before.get(key(res))
+        if old and res['wall_seconds'] > old['wall_seconds'] * (1 + tolerance):
+            slower.append((res, old))
+    return slower
+
+
+def other_host(report, baseline):
+    """Why the baseline was not measured on the same machine, if it was not"""
+    for field in ('host', 'cpus'):
+        if baseline.get(field) != report[field]:
+            return (f'the baseline has {field} {baseline.get(field)!r}, '
+                    f'this run {report[field]!r}')
+    return None
+
+
+def pair(s):
+    r, n = map(int, s.split(','))
+    return r, n
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument('--matrix', type=pair, nargs='+',
+                        default=[(4, 8), (4, 9)], help='(r, n) pairs as r,n')
+    parser.add_argument('--threads', type=int, nargs='+',
+                        default=sorted({1, 2, os.cpu_count() or 1}))
+    parser.add_argument('--modes', nargs='+', choices=MODES,
+                        default=list(MODES))
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='runs per configuration, the fastest counts')
+    parser.add_argument('--output', default='output/benchmark.json')
+    parser.add_argument('--baseline', default='output/benchmark-baseline.json')
+    parser.add_argument('--tolerance', type=float, default=0.10,
+                        help='allowed slowdown over the baseline (0.10 = 10%%)')
+    parser.add_argument('--save-baseline', action='store_true',
+                        help='also write the results as the new baseline')
+    parser.add_argument('--any-host', action='store_true',
+                        help='compare with a baseline of another host')
+    args = parser.parse_args()
+    args.threads.sort()
+
+    commit = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], cwd=ROOT,
+                            capture_output=True, text=True).stdout.strip()
+    report = {'commit': commit, 'host': platform.node(),
+              'cpus': os.cpu_count(), 'repeat': args.repeat,
+              'results': benchmark(args)}
+    output = Path(args.output)
+    output.parent.mkdir(exist_ok=True)
+    output.write_text(json.dumps(report, indent=2) + '\n')
+
+    baseline = Path(args.baseline)
+    if args.save_baseline:
+        baseline.write_text(json.dumps(report, indent=2) + '\n')
+    elif baseline.exists():
+        baseline = json.loads(baseline.read_text())
+        reason = other_host(report, baseline)
+        if reason and not args.any_host:
+            sys.exit(f'Not comparable: {reason} (use --any-host to compare)')
+        if reason:
+            print(f'Warning: {reason}', file=sys.stderr)
+        slower = regressions(report['results'], baseline, args.tolerance)
+        for res, old in slower:
+            print(f'Regression: ({res["r"]}, {res["n"]}) {res["mode"]} '
+                  f'{res["threads"]} thread(s): {res["wall_seconds"]:.3f} s '
+                  f'vs. {old["wall_seconds"]:.3f} s', file=sys.stderr)
+        if slower:
+            sys.exit(1)
@@ -1,9 +1,8 @@
 from collections import Counter
 from concurrent.futures import ProcessPoolExecutor
-from pathlib import Path
 from sage.all import *
 import argparse
-import subprocess
+import libmatroid  # scripts/libmatroid.py
 """
 Find the excluded minors over `GF(q)` up to certain number of elements.
 
@@ -13,14 +12,8 @@ Usage:
 
 
 def canonical_extensions(r, n, colex):
-    executable = Path(__file__).resolve().parents[1] / 'build' / 'IC-extend'
-    result = subprocess.run(
-        [str(executable), str(r), str(n), colex],
-        check=True,
-        capture_output=True,
-        text=True,
-    )
-    return result.stdout.splitlines()
+    # Extensions as by IC-extend, within this (worker) process
+    return libmatroid.extend(r, n, [colex])[0]
 
 
 def process_task(task):
@@ -0,0 +1,75 @@
+"""
+Python bindings of build/libmatroid.so (see src/libmatroid.h).
+
+Usage as a module:
+    import libmatroid
+    libmatroid.generate(4, 8)                  # all canonical (4, 8) matroids
+    libmatroid.generate(4, 8, simple=True)     # as IC 4 8 --simple
+    libmatroid.extend(4, 7, [colex, ...])      # extensions of each seed
+
+Usage as a script (prints the canonical (r, n) matroids, as build/IC):
+    python3 scripts/libmatroid.py <r> <n> [<num_threads>]
+"""
+from pathlib import Path
+import ctypes
+import sys
+
+IC_ABI_VERSION = 1
+IC_SIMPLE, IC_PAVING, IC_CARRY_FLATS = 1, 2, 4
+
+_lib = ctypes.CDLL(
+    str(Path(__file__).resolve().parents[1] / 'build' / 'libmatroid.so'))
+_callback = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.POINTER(ctypes.c_char),
+                             ctypes.c_size_t, ctypes.c_uint64,
+                             ctypes.c_void_p)
+_lib.ic_generate.argtypes = [ctypes.c_uint16, ctypes.c_uint16, ctypes.c_int,
+                             _callback, ctypes.c_void_p]
+_lib.ic_extend.argtypes = [ctypes.c_uint16, ctypes.c_uint16, ctypes.c_char_p,
+                           ctypes.c_size_t, ctypes.c_int, _callback,
+                           ctypes.c_void_p]
+_lib.ic_set_options.argtypes = [ctypes.c_uint]
+_lib.ic_exclude_minors.argtypes = [ctypes.c_char_p]
+if _lib.ic_abi_version() != IC_ABI_VERSION:
+    raise ImportError('libmatroid.so has an incompatible ABI version')
+
+
+def _check(status):
+    if status != 0:
+        raise ValueError(f'libmatroid error {status}')
+
+
+def generate(r, n, num_threads=1, simple=False, paving=False,
+             carry_flats=False, exclude_minors=None):
+    """All canonical (r, n) matroids as colex strings, in the order of IC,
+    restricted as by the options --simple, --paving and --exclude-minors <file>
+    of IC"""
+    result = []
+    on_matroid = _callback(
+        lambda colex, length, seed, user: result.append(
+            ctypes.string_at(colex, length).decode()) or 0)
+    _check(_lib.ic_set_options(simple * IC_SIMPLE | paving * IC_PAVING |
+                               carry_flats * IC_CARRY_FLATS))
+    _check(_lib.ic_exclude_minors(
+        str(exclude_minors).encode() if exclude_minors else None))
+    _check(_lib.ic_generate(r, n, num_threads, on_matroid, None))
+    return result
+
+
+def extend(r, n, seeds, num_threads=1):
+    """The single-element extensions (up to isomorphism) of each (r, n) seed,
+    as in IC-extend: one list of colex strings per seed"""
+    result = [[] for _ in seeds]
+    on_matroid = _callback(
+        lambda colex, length, seed, user: result[seed].append(
+            ctypes.string_at(colex, length).decode()) or 0)
+    _check(_lib.ic_extend(r, n, ''.join(seeds).encode(), len(seeds),
+                          num_threads, on_matroid, None))
+    return result
+
+
+if __name__ == '__main__':
+    if len(sys.argv) not in (3, 4):
+        sys.exit(__doc__)
+    args = [int(arg) for arg in sys.argv[1:]]
+    for colex in generate(*args):
+        print(colex)
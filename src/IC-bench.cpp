@@ -0,0 +1,248 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+#include "matroid.h"
+#include "sz.h"
+
+using namespace std;
+
+// Fixed corpus: the (4, 7) matroids are the seeds of IC(4, 8), whose output
+// (4, 8) is the input of the canonicity test and the SZ codec
+const string CORPUS_DIR = "tests/expected";
+const string SZ_FILENAME = "build/bench.sz";
+constexpr uint16_t R = 4;
+constexpr uint16_t N_SEED = 7;
+
+using Clock = chrono::steady_clock;
+
+double min_seconds = 0.5;  // measured time per kernel
+volatile size_t sink;      // keeps results of kernels alive
+
+vector<string> read_corpus(uint16_t r, uint16_t n) {
+    stringstream filename;
+    filename << CORPUS_DIR << "/r" << setw(2) << setfill('0') << r << "n"
+             << setw(2) << setfill('0') << n;
+    ifstream file(filename.str());
+    vector<string> lines;
+    string line;
+    while (getline(file, line)) lines.push_back(line);
+    return lines;
+}
+
+double seconds_since(Clock::time_point start) {
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Repeat a pass over the corpus until min_seconds are measured. A pass adds
+// its measured time to `seconds` (excluding its setup) and returns the number
+// of operations. Outputs one JSON object per line.
+void bench(const string& kernel, const string& op,
+           const function<size_t(double& seconds)>& pass) {
+    size_t ops = 0;
+    double seconds = 0;
+    while (seconds < min_seconds) ops += pass(seconds);
+    double ns = seconds * 1e9 / static_cast<double>(ops);
+    cout << fixed << setprecision(1) << "{\"kernel\": \"" << kernel
+         << "\", \"op\": \"" << op << "\", \"ops\": " << ops
+         << ", \"ns_per_op\": " << ns << ", \"ops_per_sec\": " << 1e9 / ns
+         << "}" << endl;
+}
+
+// Seed matroids initialized as by traverse_linear_subclasses
+vector<Matroid> prepare_seeds(const vector<string>& corpus) {
+    vector<Matroid> seeds;
+    for (const string& colex : corpus) {
+        seeds.emplace_back(R, N_SEED, colex);
+        seeds.back().init_ind_sets_rm1();
+        seeds.back().init_hyperplanes();
+        seeds.back().init_hyperlines();
+        seeds.back().init_taboo_hyperplanes();
+    }
+    return seeds;
+}
+
+void bench_initialize_combinatorics() {
+    bench("initialize_combinatorics", "table (n = 8, r = 4)",
+          [](double& seconds) {
+              auto start = Clock::now();
+              initialize_combinatorics(N_SEED + 1, R);
+              seconds += seconds_since(start);
+              return 1;
+          });
+}
+
+void bench_init_hyperplanes(const vector<string>& corpus) {
+    bench("Matroid::init_hyperplanes", "seed", [&](double& seconds) {
+        for (const string& colex : corpus) {
+            Matroid M(R, N_SEED, colex);
+            M.init_ind_sets_rm1();
+            auto start = Clock::now();
+            M.init_hyperplanes();
+            seconds += seconds_since(start);
+            sink = M.hyperplanes.size();
+        }
+        return corpus.size();
+    });
+}
+
+void bench_init_hyperlines(const vector<string>& corpus) {
+    bench("Matroid::init_hyperlines", "seed", [&](double& seconds) {
+        for (const string& colex : corpus) {
+            Matroid M(R, N_SEED, colex);
+            M.init_ind_sets_rm1();
+            M.init_hyperplanes();
+            auto start = Clock::now();
+            M.init_hyperlines();
+            seconds += seconds_since(start);
+            sink = M.hyperlines.size();
+        }
+        return corpus.size();
+    });
+}
+
+// Insert or remove each hyperplane of each seed in the initial node
+void bench_node(const vector<Matroid>& seeds, bool insert) {
+    bench(insert ? "Node::insert_plane" : "Node::remove_plane", "plane",
+          [&](double& seconds) {
+              size_t ops = 0;
+              for (const Matroid& M : seeds) {
+                  Node first_node(&M);
+                  size_t planes = M.hyperplanes.size();
+                  vector<Node> nodes(planes, first_node);
+                  auto start = Clock::now();
+                  for (size_t p = 0; p < planes; ++p) {
+                      if (insert)
+                          sink = nodes[p].insert_plane(p);
+                      else
+                          nodes[p].remove_plane(p);
+                  }
+                  seconds += seconds_since(start);
+                  ops += planes;
+              }
+              return ops;
+          });
+}
+
+// Search over the linear subclasses of each seed, including the canonicity
+// tests of the leaves and their per-seed precomputation, as in
+// traverse_linear_subclasses
+void bench_dfs_search(const vector<Matroid>& seeds) {
+    bench("dfs_search", "seed", [&](double& seconds) {
+        size_t extensions = 0;
+        auto on_extension = [&](const Matroid&) { extensions++; };
+        for (const Matroid& M : seeds) {
+            string base_colex_ext(bnml_nm1_rm1, '0');
+            for (bitset<N> I : M.ind_sets_rm1) {
+                I.set(M.n);
+                base_colex_ext[set_to_index[I.to_ulong()] - bnml_nm1] = '*';
+            }
+            Node first_node(&M);
+            for (bitset<N> T : M.taboo_hyperplanes)
+                first_node.remove_plane(M.hyperplanes_index[T]);
+            auto start = Clock::now();
+            init_prefix_branches(M, prefix_branches);
+            last_witness = Witness();
+            string M_ext = M.colex + base_colex_ext;
+            dfs_search(first_node, base_colex_ext, M_ext, on_extension);
+            seconds += seconds_since(start);
+        }
+        sink = extensions;
+        return seeds.size();
+    });
+}
+
+void bench_is_canonical(const vector<string>& corpus) {
+    bench("is_canonical", "canonical matroid", [&](double& seconds) {
+        auto start = Clock::now();
+        for (const string& colex : corpus)
+            sink = is_canonical(colex.data(), R, N_SEED + 1);
+        seconds += seconds_since(start);
+        return corpus.size();
+    });
+}
+
+void bench_sz(const vector<string>& corpus) {
+    bench("SZWriter", "line", [&](double& seconds) {
+        auto start = Clock::now();
+        SZWriter writer;
+        writer.open(SZ_FILENAME);
+        for (const string& colex : corpus) writer.write(colex);
+        writer.close();
+        seconds += seconds_since(start);
+        return corpus.size();
+    });
+    bench("SZReader", "line", [&](double& seconds) {
+        auto start = Clock::now();
+        SZReader reader;
+        reader.open(SZ_FILENAME);
+        string line;
+        size_t lines = 0;
+        while (reader.getline(line)) lines++;
+        reader.close();
+        seconds += seconds_since(start);
+        return lines;
+    });
+    filesystem::remove(SZ_FILENAME);
+}
+
+// The kernels that can be selected on the command line
+const set<string> KERNELS = {
+    "initialize_combinatorics", "init_hyperplanes", "init_hyperlines",
+    "insert_plane", "remove_plane", "dfs_search", "is_canonical", "sz"};
+
+int main(int argc, char* argv[]) {
+    set<string> kernels;  // all if empty
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc) {
+            min_seconds = stod(argv[++i]);
+        } else if (arg[0] != '-' && KERNELS.count(arg)) {
+            kernels.insert(arg);
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [<kernel>...] [--min-time <seconds>]\nKernels:";
+            for (const string& kernel : KERNELS) cerr << " " << kernel;
+            cerr << endl;
+            return 1;
+        }
+    }
+    auto selected = [&](const string& kernel) {
+        return kernels.empty() || kernels.count(kernel);
+    };
+
+    vector<string> seeds_corpus = read_corpus(R, N_SEED);
+    vector<string> corpus = read_corpus(R, N_SEED + 1);
+    if (seeds_corpus.empty() || corpus.empty()) {
+        cerr << "Failed to read the corpus in " << CORPUS_DIR
+             << " (run from the repository root)" << endl;
+        return 1;
+    }
+
+    // Tables of the extension of the seeds, as in IC(4, 8)
+    allocate_combinatorics(N_SEED + 1, R);
+    initialize_combinatorics(N_SEED + 1, R);
+    vector<Matroid> seeds = prepare_seeds(seeds_corpus);
+
+    if (selected("initialize_combinatorics")) bench_initialize_combinatorics();
+    if (selected("init_hyperplanes")) bench_init_hyperplanes(seeds_corpus);
+    if (selected("init_hyperlines")) bench_init_hyperlines(seeds_corpus);
+    if (selected("insert_plane")) bench_node(seeds, true);
+    if (selected("remove_plane")) bench_node(seeds, false);
+    if (selected("dfs_search")) bench_dfs_search(seeds);
+    if (selected("is_canonical")) bench_is_canonical(corpus);
+    if (selected("sz")) bench_sz(corpus);
+
+    free_combinatorics();
+
+    return 0;
+}
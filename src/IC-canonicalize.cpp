@@ -0,0 +1,92 @@
+#include <omp.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+#include "matroid.h"
+#include "sz.h"
+
+using namespace std;
+
+constexpr size_t BATCH_SIZE = 1 << 16;  // lines canonicalized per batch
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 5) {
+        cerr << "Usage: " << argv[0] << " <r> <n> [<num_threads>] [<file>]"
+             << endl;
+        return 1;
+    }
+
+    // Parse arguments
+    uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
+    uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
+    int num_threads = 1;
+    string filename = "-";
+    for (int i = 3; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.find_first_not_of("0123456789") == string::npos)
+            num_threads = stoi(arg);
+        else
+            filename = arg;
+    }
+    omp_set_num_threads(num_threads);
+
+    if (r > n || n >= N) {
+        cerr << "Invalid matroid size: expected r <= n < " << N << endl;
+        return 1;
+    }
+
+    ColexReader reader;
+    if (!reader.open(filename)) {
+        cerr << "Failed to open " << filename << endl;
+        return 1;
+    }
+
+    if (r > 0 && r < n) {
+        allocate_combinatorics(n, r);
+        initialize_combinatorics(n, r);
+    } else {
+        bnml = 1;  // only "*" (canonical by itself)
+    }
+    const size_t len = binomial(n, r);
+
+    // Each output line: <canonical colex> <perm>, where element e of the
+    // canonical matroid is element perm[e] of the input matroid
+    vector<string> batch;
+    vector<string> results;
+    string line;
+    bool done = false;
+    while (!done) {
+        batch.clear();
+        while (batch.size() < BATCH_SIZE && !(done = !reader.getline(line))) {
+            if (line.size() != len) {
+                cerr << "Invalid colex string of length " << line.size()
+                     << " (expected C(n, r) = " << len << ")" << endl;
+                return 1;
+            }
+            batch.push_back(line);
+        }
+
+        results.assign(batch.size(), "");
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t i = 0; i < batch.size(); ++i) {
+            vector<uint16_t> perm;
+            string& res = results[i];
+            res = canonicalize(batch[i].data(), r, n, &perm);
+            res += ' ';
+            for (uint16_t e = 0; e < n; ++e) {
+                if (e > 0) res += ',';
+                res += to_string(perm[e]);
+            }
+        }
+
+        for (const string& res : results) cout << res << '\n';
+    }
+
+    free_combinatorics();
+
+    return 0;
+}
@@ -1,45 +1,139 @@
+#include <omp.h>
+
 #include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "combinatorics.h"
 #include "matroid.h"
+#include "sz.h"
 
 using namespace std;
 
+constexpr size_t BATCH_SIZE = 1 << 12;  // seeds extended per batch
+
+uint16_t r, n;
+
+// Canonical single-element extensions of the (r, n) matroid colex, followed by
+// the extension by a coloop
+vector<string> extensions(const string& colex) {
+    vector<string> result;
+    Matroid M(r, n, colex);
+    M.canonical_extensions(
+        [&](const Matroid& extension) { result.push_back(extension.colex); });
+    result.push_back(string(binomial(n, r + 1), '0') + colex);
+    return result;
+}
+
+bool valid(const string& colex) {
+    if (colex.size() == binomial(n, r)) return true;
+    cerr << "Invalid colex string of length " << colex.size()
+         << " (expected C(n, r) = " << binomial(n, r) << ")" << endl;
+    return false;
+}
+
+// Extend all seeds of a file in parallel, output lines "<index> <extension>"
+// with the (0-based) index of the seed in the file
+int extend_batch(const string& filename) {
+    ColexReader reader;
+    if (!reader.open(filename)) {
+        cerr << "Failed to open " << filename << endl;
+        return 1;
+    }
+
+    size_t index = 0;
+    vector<string> batch;
+    vector<vector<string>> results;
+    string line;
+    bool done = false;
+    while (!done) {
+        batch.clear();
+        while (batch.size() < BATCH_SIZE && !(done = !reader.getline(line))) {
+            if (!valid(line)) return 1;
+            batch.push_back(line);
+        }
+
+        results.assign(batch.size(), {});
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < batch.size(); ++i) {
+            results[i] = extensions(batch[i]);
+        }
+
+        for (const vector<string>& result : results) {
+            for (const string& extension : result)
+                cout << index << ' ' << extension << '\n';
+            index++;
+        }
+    }
+    return 0;
+}
+
+// Line protocol for drivers keeping one process: for each seed read from
+// stdin, output its extensions followed by an empty line (only the empty line
+// for invalid seeds)
+int serve() {
+    string line;
+    while (getline(cin, line)) {
+        if (!valid(line)) {
+            cout << endl;
+            continue;
+        }
+        for (const string& extension : extensions(line))
+            cout << extension << '\n';
+        cout << endl;  // flush
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        cerr << "Usage: " << argv[0] << " <r> <n> <colex>" << endl;
+    const bool batch_or_serve = argc >= 4 && (string(argv[3]) == "--batch" ||
+                                              string(argv[3]) == "--serve");
+    if (argc < 4 || argc > (batch_or_serve ? 6 : 4)) {
+        cerr << "Usage: " << argv[0] << " <r> <n> <colex>\n"
+             << "       " << argv[0]
+             << " <r> <n> --batch [<file>] [<num_threads>]\n"
+             << "       " << argv[0] << " <r> <n> --serve" << endl;
         return 1;
     }
 
-    uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
-    uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
-    const string colex = argv[3];
+    r = static_cast<uint16_t>(stoul(argv[1]));
+    n = static_cast<uint16_t>(stoul(argv[2]));
+    const string mode = argv[3];
     const uint16_t np1 = n + 1;
 
-    if (r == 0 || r > n || np1 > N || colex.size() != binomial(n, r)) {
+    if (r == 0 || r > n || np1 > N) {
         cerr << "Invalid matroid: expected 0 < r <= n < " << N
              << " and a colex string of length C(n, r)" << endl;
         return 1;
     }
 
-    P = new uint16_t[binomial(np1, r) * factorial(r) * binomial(np1, r)];
-    T = new uint16_t[factorial(np1 - r) * binomial(np1, r)];
-    index_to_set.resize(binomial(np1, r));
-    f.resize(np1 + 1);
-    C_r.resize(np1 + 2);
-    r_set_to_perm_reps.resize(binomial(np1, r) * factorial(r));
-    initialize_combinatorics(np1, r);
+    string filename = "-";
+    for (int i = 4; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.find_first_not_of("0123456789") == string::npos)
+            omp_set_num_threads(stoi(arg));
+        else
+            filename = arg;
+    }
 
-    Matroid M(r, n, colex);
-    M.canonical_extensions(
-        [](const Matroid& extension) { cout << extension.colex << '\n'; });
+    // Tables are initialized once for all seeds
+    allocate_combinatorics(np1, r);
+    initialize_combinatorics(np1, r);
 
-    delete[] P;
-    delete[] T;
+    int status = 0;
+    if (mode == "--batch") {
+        status = extend_batch(filename);
+    } else if (mode == "--serve") {
+        status = serve();
+    } else if (valid(mode)) {
+        for (const string& extension : extensions(mode))
+            cout << extension << '\n';
+    } else {
+        status = 1;
+    }
 
-    cout << string(binomial(n, r + 1), '0') + colex << '\n';
+    free_combinatorics();
 
-    return 0;
+    return status;
 }
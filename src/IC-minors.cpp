@@ -0,0 +1,145 @@
+#include <omp.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "combinatorics.h"
+#include "filename.h"
+#include "matroid.h"
+#include "sz.h"
+
+using namespace std;
+
+constexpr size_t BATCH_SIZE = 1 << 16;    // matroids processed per batch
+constexpr uint32_t SAME_MINOR = UINT32_MAX;  // M\e = M/e (coloop or loop)
+
+string sz_filename(size_t r, size_t n) { return level_filename(r, n) + ".sz"; }
+
+// Map each canonical (r, n) matroid to its index in output/r__n__.sz
+bool read_index(size_t r, size_t n, unordered_map<string, uint32_t>& index) {
+    SZReader reader;
+    if (!reader.open(sz_filename(r, n))) {
+        cerr << "Failed to open " << sz_filename(r, n) << endl;
+        return false;
+    }
+    string line;
+    while (reader.getline(line)) {
+        index.emplace(line, static_cast<uint32_t>(index.size()));
+    }
+    return true;
+}
+
+// For each (r, n) matroid, compute the index of the canonical form of its
+// minor of rank r_minor given by the colex substring [start, start + len).
+// A substring of only '0's means that the minor has a different rank.
+bool minor_indices(uint16_t r, uint16_t n, uint16_t r_minor, size_t start,
+                   size_t len, vector<uint32_t>& indices) {
+    unordered_map<string, uint32_t> index;
+    if (!read_index(r_minor, n - 1, index)) return false;
+
+    if (r_minor > 0 && r_minor < n - 1) {
+        allocate_combinatorics(n - 1, r_minor);
+        initialize_combinatorics(n - 1, r_minor);
+    } else {
+        bnml = 1;  // only "*" (canonical by itself)
+    }
+
+    SZReader reader;
+    if (!reader.open(sz_filename(r, n))) {
+        cerr << "Failed to open " << sz_filename(r, n) << endl;
+        return false;
+    }
+
+    vector<string> batch;
+    string line;
+    bool done = false, found = true;
+    while (!done) {
+        batch.clear();
+        while (batch.size() < BATCH_SIZE && !(done = !reader.getline(line))) {
+            batch.push_back(line.substr(start, len));
+        }
+
+        size_t offset = indices.size();
+        indices.resize(offset + batch.size());
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const string& colex = batch[i];
+            if (colex.find('*') == string::npos) {
+                indices[offset + i] = SAME_MINOR;
+                continue;
+            }
+            // Minors already in canonical form (e.g. all deletions of IC
+            // output) are found without canonicalization
+            auto it = index.find(colex);
+            if (it == index.end())
+                it = index.find(canonicalize(colex.data(), r_minor, n - 1));
+            if (it == index.end()) {
+#pragma omp critical(io)
+                {
+                    cerr << "Minor " << colex << " not found in "
+                         << sz_filename(r_minor, n - 1) << endl;
+                    found = false;
+                }
+                continue;
+            }
+            indices[offset + i] = it->second;
+        }
+    }
+
+    free_combinatorics();
+    return found;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 4) {
+        cerr << "Usage: " << argv[0] << " <r> <n> [<num_threads>]" << endl;
+        return 1;
+    }
+
+    // Parse arguments
+    uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
+    uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
+    if (argc == 4) omp_set_num_threads(stoi(argv[3]));
+
+    if (r == 0 || r >= n || n >= N) {
+        cerr << "Invalid matroid size: expected 0 < r < n < " << N << endl;
+        return 1;
+    }
+
+    // The first C(n - 1, r) positions of the colex string form the deletion
+    // M\e of the last element e, the last C(n - 1, r - 1) ones the
+    // contraction M/e
+    size_t len_deletion = binomial(n - 1, r);
+    size_t len_contraction = binomial(n - 1, r - 1);
+
+    vector<uint32_t> deletion, contraction;
+    if (!minor_indices(r, n, r, 0, len_deletion, deletion) ||
+        !minor_indices(r, n, r - 1, len_deletion, len_contraction,
+                       contraction))
+        return 1;
+
+    // Output: uint64 count, followed by count pairs of uint32 indices
+    // (deletion, contraction). The index SAME_MINOR signifies that e is a
+    // coloop (deletion) or a loop (contraction), in which case M\e = M/e.
+    string filename = sz_filename(r, n);
+    filename.replace(filename.size() - 3, 3, "-minors.bin");
+    ofstream out(filename, ios::binary);
+    uint64_t count = deletion.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (size_t i = 0; i < deletion.size(); ++i) {
+        out.write(reinterpret_cast<const char*>(&deletion[i]),
+                  sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(&contraction[i]),
+                  sizeof(uint32_t));
+    }
+    out.close();
+
+    cout << "Wrote minor indices of " << count << " matroids to " << filename
+         << endl;
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <omp.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+#include "properties.h"
+#include "sz.h"
+
+using namespace std;
+
+constexpr size_t BATCH_SIZE = 1 << 16;  // matroids processed per batch
+
+string output_prefix(size_t r, size_t n) {
+    stringstream filename;
+    filename << "output/r" << setw(2) << setfill('0') << r << "n" << setw(2)
+             << setfill('0') << n;
+    return filename.str();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 5) {
+        cerr << "Usage: " << argv[0] << " <r> <n> [<num_threads>] [--detailed]"
+             << endl;
+        return 1;
+    }
+
+    // Parse arguments
+    uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
+    uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
+    bool detailed = false;
+    for (int i = 3; i < argc; ++i) {
+        if (string(argv[i]) == "--detailed")
+            detailed = true;
+        else
+            omp_set_num_threads(stoi(argv[i]));
+    }
+
+    if (r > n || n >= N) {
+        cerr << "Invalid matroid size: expected r <= n < " << N << endl;
+        return 1;
+    }
+
+    string prefix = output_prefix(r, n);
+    SZReader reader;
+    if (!reader.open(prefix + ".sz")) {
+        cerr << "Failed to open " << prefix << ".sz" << endl;
+        return 1;
+    }
+
+    ofstream detailed_file;
+    if (detailed) {
+        detailed_file.open(prefix + "-invariants.json");
+        detailed_file << "{";
+    }
+
+    const vector<bitset<N>> sets = combinations<N>(n, r);
+    const char* keys[] = {"loopless", "coloopless", "simple", "connected",
+                          "paving"};
+    size_t cnt_all = 0;
+    size_t cnt[5] = {0, 0, 0, 0, 0};
+
+    vector<string> batch;
+    vector<Properties> props;
+    string line;
+    bool done = false;
+    while (!done) {
+        batch.clear();
+        while (batch.size() < BATCH_SIZE && !(done = !reader.getline(line))) {
+            batch.push_back(line);
+        }
+
+        props.resize(batch.size());
+#pragma omp parallel
+        {
+            vector<uint8_t> rank;
+#pragma omp for schedule(dynamic, 64)
+            for (size_t i = 0; i < batch.size(); ++i) {
+                props[i] = compute_properties(r, n, batch[i], sets, rank);
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const Properties& p = props[i];
+            bool values[] = {p.loopless, p.coloopless, p.simple, p.connected,
+                             p.paving};
+            for (size_t k = 0; k < 5; ++k) cnt[k] += values[k];
+            if (detailed) {
+                detailed_file << (cnt_all ? ",\n" : "\n") << "  \"" << batch[i]
+                              << "\": ";
+                write_properties_json(detailed_file, p, 1);
+            }
+            cnt_all++;
+        }
+    }
+
+    if (detailed) {
+        detailed_file << (cnt_all ? "\n}" : "}");
+        detailed_file.close();
+    }
+
+    // Same layout as the -properties-counts.json files of the
+    // properties-from-minors workflow
+    ofstream counts_file(prefix + "-invariants-counts.json");
+    counts_file << "{\n  \"all\": " << cnt_all;
+    for (size_t k = 0; k < 5; ++k) {
+        counts_file << ",\n  \"" << keys[k] << "\": " << cnt[k];
+    }
+    counts_file << "\n}";
+    counts_file.close();
+
+    return 0;
+}
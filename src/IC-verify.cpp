@@ -0,0 +1,154 @@
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+#include "extension.h"
+#include "filename.h"
+#include "properties.h"
+#include "sz.h"
+
+using namespace std;
+
+constexpr size_t BATCH_SIZE = 1 << 16;  // lines checked per batch
+
+string sz_filename(size_t r, size_t n) { return level_filename(r, n) + ".sz"; }
+
+// Whether colex is the set of bases of a matroid. The ranks computed from the
+// bases by rank_table satisfy r(X) <= r(X + e) <= r(X) + 1, so it suffices to
+// check r(X + e) = r(X + f) = r(X) => r(X + e + f) = r(X). With the bitmask
+// L(X) of the elements e outside X with r(X + e) = r(X), this reads
+// L(X) - e is a subset of L(X + e) for all e in L(X), checked for all
+// elements at once.
+bool is_matroid(uint16_t n, const string& colex, const vector<bitset<N>>& sets,
+                vector<uint8_t>& rank, vector<uint32_t>& L) {
+    if (colex.find('*') == string::npos) return false;
+    rank_table(n, colex, sets, rank);
+    const uint32_t full = (uint32_t(1) << n) - 1;
+    L.assign(full + 1, 0);
+    for (uint32_t X = 0; X <= full; ++X) {
+        for (uint32_t Y = full & ~X; Y; Y &= Y - 1) {
+            uint32_t e = Y & -Y;
+            if (rank[X | e] == rank[X]) L[X] |= e;
+        }
+    }
+    for (uint32_t X = 0; X <= full; ++X) {
+        for (uint32_t Y = L[X]; Y; Y &= Y - 1) {
+            uint32_t e = Y & -Y;
+            if (L[X] & ~e & ~L[X | e]) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // The file comes after the number of threads, so any name is taken as one
+    const string threads =
+        argc > 3 ? argv[3] : to_string(omp_get_max_threads());
+    if (argc < 3 || argc > 5 || threads.empty() ||
+        threads.find_first_not_of("0123456789") != string::npos) {
+        cerr << "Usage: " << argv[0] << " <r> <n> [<num_threads> [<file>]]"
+             << endl;
+        return 1;
+    }
+
+    // Parse arguments
+    uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
+    uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
+    omp_set_num_threads(stoi(threads));
+    string filename = argc > 4 ? argv[4] : sz_filename(r, n);
+
+    if (r > n || n >= N) {
+        cerr << "Invalid matroid size: expected r <= n < " << N << endl;
+        return 1;
+    }
+
+    SZReader reader;
+    if (!reader.open(filename)) {
+        cerr << "Failed to open " << filename << endl;
+        return 1;
+    }
+
+    if (reader.get_line_len() != binomial(n, r)) {
+        cerr << filename << ": lines of length " << reader.get_line_len()
+             << " instead of C(n, r) = " << binomial(n, r) << endl;
+        return 1;
+    }
+
+    if (r > 0 && r < n) {
+        allocate_combinatorics(n, r);
+        initialize_combinatorics(n, r);
+    }
+    const vector<bitset<N>> sets = combinations<N>(n, r);
+
+    // Reason of the failure of each line of a batch, empty if valid
+    vector<string> batch, failures;
+    string line, prev;
+    size_t count = 0;
+    bool done = false;
+    auto fail = [&](size_t line_number, const string& reason) {
+        cerr << filename << ": line " << line_number << ": " << reason << endl;
+        return 1;
+    };
+    while (!done) {
+        batch.clear();
+        while (batch.size() < BATCH_SIZE && !(done = !reader.getline(line)))
+            batch.push_back(line);
+
+        failures.assign(batch.size(), "");
+#pragma omp parallel
+        {
+            vector<uint8_t> rank;
+            vector<uint32_t> L;
+#pragma omp for schedule(dynamic, 64)
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const string& colex = batch[i];
+                if (!is_matroid(n, colex, sets, rank, L)) {
+                    failures[i] = "not a matroid (rank axiom fails)";
+                } else if (r > 0 && r < n) {
+                    // is_canonical maps a non-basis to the first r-set, so it
+                    // assumes that the first r-set is a non-basis if any
+                    uint16_t j_fail =
+                        colex[0] == '*' && colex.find('0') != string::npos
+                            ? 0
+                            : is_canonical(colex.data(), r, n);
+                    if (j_fail != bnml)
+                        failures[i] = "not canonical (fails at position " +
+                                      to_string(j_fail) + ")";
+                }
+            }
+        }
+
+        // Strictly increasing order, also against the previous batch
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const string& before = i > 0 ? batch[i - 1] : prev;
+            if (!failures[i].empty()) return fail(count + i + 1, failures[i]);
+            if (count + i > 0 && before >= batch[i]) {
+                const char* reason = before == batch[i]
+                                         ? "duplicate of the previous line"
+                                         : "smaller than the previous line";
+                return fail(count + i + 1, reason);
+            }
+        }
+        if (!batch.empty()) prev = batch.back();
+        count += batch.size();
+    }
+
+    if (reader.get_expected_count() == UINT64_MAX)
+        return fail(count, "incomplete file (no line count in the header)");
+    if (reader.get_remaining() > 0 || count != reader.get_expected_count())
+        return fail(count, "truncated: " + to_string(count) + " of " +
+                               to_string(reader.get_expected_count()) +
+                               " lines in the header");
+    if (!reader.is_complete())
+        return fail(count, "trailing data after the last line");
+
+    free_combinatorics();
+    cout << filename << ": " << count
+         << " matroids, valid, canonical and strictly increasing" << endl;
+    return 0;
+}
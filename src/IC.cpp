@@ -1,112 +1,389 @@
 #include <omp.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "census.h"
 #include "combinatorics.h"
+#include "engine.h"
+#include "estimate.h"
 #include "file.h"
 #include "matroid.h"
+#include "minors.h"
+#include "numa.h"
+#include "perf.h"
+#include "progress.h"
+#include "schedule.h"
+#include "stats.h"
+#include "sz.h"
+#include "visitor.h"
 
 using namespace std;
 
 int num_threads = 1;
+unique_ptr<Visitor> visitor;  // replaces the output, if set
+unique_ptr<Progress> progress;  // reports the counters of stats.h, if set
+constexpr chrono::seconds PROGRESS_INTERVAL(5);
+bool schedule_longest_first = false;  // else in index order
+string cost_report;  // filename of the measured vs predicted seed costs
+unique_ptr<NumaTables> numa;  // NUMA-aware mode, if set
+unique_ptr<PerfReport> perf;  // hardware counters per phase, if set
 
-vector<string> IC(uint16_t r, uint16_t n, bool top_level = true) {
-    // Base cases
-    if (n < r) {
-        return {};
-    } else if (r == 0 || n == r) {
-        Matroid M(r, n, "*");
-        if (top_level) output_matroid(M, 0, 0);
-        return {M.colex};
-    }
-
-    if (top_level) {
-        // These sizes suffice because the recursive calls are
-        // (n - 1, r) and (n - 1, r - 1)
-        P = new uint16_t[binomial(n, r) * factorial(r) * binomial(n, r)];
-        T = new uint16_t[factorial(n - r) * binomial(n, r)];
-        index_to_set.resize(binomial(n, r));
-        f.resize(n + 1);
-        C_r.resize(n + 2);
-        r_set_to_perm_reps.resize(binomial(n, r) * factorial(r));
-    }
-
-    // Recursive calls
-    vector<string> IC_nm1 = IC(r, n - 1, false);
-    vector<string> IC_rm1_nm1 = IC(r - 1, n - 1, false);
+// Pass a top-level matroid to the visitor, or output it
+inline void emit_matroid(const Matroid& M, const size_t& index, int tid) {
+    if (visitor)
+        visitor->visit(M, index, tid);
+    else
+        output_matroid(M, tid);
+}
 
-    // Initialize factorials, binomial coefficients,
-    // mappings between indices and sets,
-    // and fill permutation array of size n! * C(n, r)
-    initialize_combinatorics(n, r);
+// The output files, sharding, scheduling and reporting of IC around the
+// recursion of engine.h
+class ICDriver : public Driver {
+   private:
+    vector<size_t> top_seeds;  // pending, for the cost report
+    vector<SeedCost> costs;
+
+   public:
+    bool pending(size_t index) override { return seed_pending(index); }
 
-    // Process IC_nm1
-    vector<string> matroids;
-    vector<vector<string>> local_matroids(!top_level ? IC_nm1.size() : 0);
+    void schedule(uint16_t r, uint16_t n, const vector<string>& IC_nm1,
+                  vector<size_t>& order) override {
+        if (!schedule_longest_first && cost_report.empty()) return;
+        costs.resize(IC_nm1.size());
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t k = 0; k < order.size(); ++k) {
+            size_t i = order[k];
+            costs[i] = estimate_cost(Matroid(r, n - 1, IC_nm1[i]),
+                                     !cost_report.empty());
+        }
+        top_seeds = order;
+        if (schedule_longest_first) order = longest_first(order, costs);
+    }
+
+    void begin_level(uint16_t r, uint16_t n, size_t seeds) override {
+        if (numa) numa->replicate(n, r);
+        if (progress) progress->begin_level(r, n, seeds);
+    }
+
+    void end_level(bool top_level) override {
+        if (top_level && !cost_report.empty())
+            write_cost_report(cost_report, top_seeds, costs);
+        if (progress) progress->end_level();
+    }
+
+    void extend(const vector<size_t>& order, bool top_level,
+                const ExtendSeed& extend_seed) override {
+        if (numa) numa->deal(order);
 #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
+        {
+            int tid = omp_get_thread_num();
+            if (progress) progress->attach(tid);
+            if (perf) perf->attach(tid);
+            if (numa) {
+                // Seeds of the queue of the thread's node first
+                numa->attach(tid);
+                size_t i;
+                while (numa->pop(tid, i)) extend_seed(i, tid);
+                NumaTables::detach();
+            } else {
 #pragma omp for schedule(dynamic, 1) nowait
-        for (size_t i = 0; i < IC_nm1.size(); ++i) {
-            Matroid M(r, n - 1, IC_nm1[i]);
-            // Iterate over all canonical extensions
-            M.canonical_extensions([&](Matroid M_ext) {
-                if (top_level)
-                    output_matroid(M_ext, i, tid);
-                else
-                    local_matroids[i].push_back(M_ext.colex);
-            });
+                for (size_t k = 0; k < order.size(); ++k)
+                    extend_seed(order[k], tid);
+            }
+            if (perf) PerfReport::detach();
+        }
+        if (numa && top_level) numa->report();
+    }
+
+    void emit(const Matroid& M, size_t index, int tid) override {
+        emit_matroid(M, index, tid);
+    }
+
+    void seed_done(size_t index, int tid, double seconds) override {
+        if (index < costs.size()) costs[index].measured = seconds;
+        complete_seed(index, tid);
+    }
+};
+
+// The canonical (r, n) matroids, output at the top level
+vector<string> IC(uint16_t r, uint16_t n, bool top_level = true) {
+    ICDriver driver;
+    return IC_generate(r, n, driver, top_level);
+}
+
+// Parse a nonnegative decimal number, returning false if arg is none
+bool parse_number(const string& arg, size_t& value) {
+    if (arg.empty() || arg.find_first_not_of("0123456789") != string::npos)
+        return false;
+    try {
+        value = stoul(arg);
+    } catch (const out_of_range&) {
+        return false;
+    }
+    return true;
+}
+
+// The canonical (n - r, n) matroids, read from the .sz file of that level if
+// it is complete, else generated. Text files carry no line count, so a
+// truncated one cannot be told from a complete one and is not read.
+vector<string> dual_level(uint16_t r, uint16_t n) {
+    uint16_t r_dual = n - r;
+    const string filename = base_filename(r_dual, n) + ".sz";
+    if (filesystem::exists(filename)) {
+        SZReader reader;
+        vector<string> matroids;
+        string line;
+        if (reader.open(filename) &&
+            reader.get_line_len() == binomial(n, r_dual) &&
+            reader.get_expected_count() != UINT64_MAX)
+            while (reader.getline(line)) matroids.push_back(line);
+        if (!matroids.empty() &&
+            matroids.size() == reader.get_expected_count() &&
+            reader.is_complete()) {
+            cerr << "Read " << matroids.size() << " (" << r_dual << ", " << n
+                 << ") matroids from " << filename << endl;
+            return matroids;
         }
+        cerr << "Ignoring the incomplete " << filename << endl;
+    }
+    allocate_combinatorics(n, r_dual);
+    return IC(r_dual, n, false);
+}
+
+// Generate the canonical (r, n) matroids as the duals of the (n - r, n)
+// matroids, whose bases are the complements. Complementation reverses the
+// colex order, so the colex string of a dual is the reversed string. The duals
+// are canonicalized and sorted into the order of IC(), as seed 0.
+void IC_via_dual(uint16_t r, uint16_t n) {
+    if (!seed_pending(0)) return;
+    vector<string> matroids = dual_level(r, n);
+
+    allocate_combinatorics(n, r);
+    initialize_combinatorics(n, r);
+    if (progress) progress->begin_level(r, n, 1);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < matroids.size(); ++i) {
+        string dual(matroids[i].rbegin(), matroids[i].rend());
+        matroids[i] = canonicalize(dual.data(), r, n);
     }
+    sort(matroids.begin(), matroids.end());
 
-    for (auto& v : local_matroids) {
-        matroids.insert(matroids.end(), make_move_iterator(v.begin()),
-                        make_move_iterator(v.end()));
+    for (const string& colex : matroids)
+        emit_matroid(Matroid(r, n, colex), 0, 0);
+    complete_seed(0, 0);
+    if (thread_stats) {
+        bump(thread_stats->seeds);
+        bump(thread_stats->extensions, matroids.size());
     }
+    if (progress) progress->end_level();
+}
 
-    // Process IC_rm1_nm1
-    for (const string& colex : IC_rm1_nm1) {
-        Matroid M(r - 1, n - 1, colex);
-        Matroid M_ext = M.coloop_extension();
-        if (top_level)
-            output_matroid(M_ext, IC_nm1.size(), 0);
-        else
-            matroids.push_back(move(M_ext.colex));
+// Estimate the run of IC(r, n) by generating the lower levels and sampling
+// the extensions of the seeds
+void IC_estimate(uint16_t r, uint16_t n) {
+    if (r == 0 || n <= r) {
+        estimate_level(r, n, {}, IC(r, n, false).size(), 0);
+        return;
     }
+    allocate_combinatorics(n, r);
+    vector<string> IC_nm1 = IC(r, n - 1, false);
+    vector<string> IC_rm1_nm1 = IC(r - 1, n - 1, false);
+    initialize_combinatorics(n, r);
+
+    size_t coloop_extensions = 0;
+    for (const string& colex : IC_rm1_nm1)
+        if (!paving_only || colex.find('0') == string::npos)
+            coloop_extensions++;
+    estimate_level(r, n, IC_nm1, coloop_extensions, cpu_seconds());
+}
 
-    return matroids;
+void usage(const char* program) {
+    cout << "Usage: " << program
+         << " <r> <n> [<num_threads>] [--file] [--compressed-file] "
+            "[--binary]\n"
+            "       [--census] [--shard <i>/<k>] [--merge-shards <k>] "
+            "[--resume]\n"
+            "       [--checkpoint <seconds>] [--progress] "
+            "[--stats-file <file>]\n"
+            "       [--longest-first] [--cost-report <file>] [--simple] "
+            "[--paving]\n"
+            "       [--no-early-pruning] [--async-io] [--io-depth <k>] "
+            "[--via-dual]\n"
+            "       [--estimate] [--estimate-samples <k>] [--numa] "
+            "[--huge-pages]\n"
+            "       [--perf-counters] [--carry-flats] "
+            "[--exclude-minors <file>]"
+         << endl;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 3 || argc > 6) {
-        cout << "Usage: " << argv[0]
-             << " <r> <n> [<num_threads>] [--file] [--compressed-file]" << endl;
+    if (argc < 3) {
+        usage(argv[0]);
         return 1;
     }
 
     // Parse arguments
     uint16_t r = static_cast<uint16_t>(stoul(argv[1]));
     uint16_t n = static_cast<uint16_t>(stoul(argv[2]));
+    bool census = false;
+    bool merge = false;
+    bool resume = false;
+    bool show_progress = false;
+    bool via_dual = false;
+    bool estimate = false;
+    bool perf_counters = false;
+    string stats_filename;
     for (int i = 3; i < argc; ++i) {
-        if (string(argv[i]) == "--file") {
+        string arg = argv[i];
+        if (arg == "--file") {
             to_file = true;
-        } else if (string(argv[i]) == "--compressed-file") {
+        } else if (arg == "--compressed-file") {
             to_file = true;
             use_compression = true;
+        } else if (arg == "--binary") {
+            to_file = true;
+            use_binary = true;
+        } else if (arg == "--census") {
+            census = true;
+        } else if (arg == "--shard" && i + 1 < argc) {
+            string shard = argv[++i];
+            size_t slash = shard.find('/');
+            if (slash == string::npos ||
+                !parse_number(shard.substr(0, slash), shard_index) ||
+                !parse_number(shard.substr(slash + 1), num_shards)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--merge-shards" && i + 1 < argc) {
+            merge = true;
+            if (!parse_number(argv[++i], num_shards)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--progress") {
+            show_progress = true;
+        } else if (arg == "--stats-file" && i + 1 < argc) {
+            stats_filename = argv[++i];
+        } else if (arg == "--simple") {
+            simple_only = true;
+        } else if (arg == "--paving") {
+            paving_only = true;
+        } else if (arg == "--async-io") {
+            async_io = true;
+        } else if (arg == "--io-depth" && i + 1 < argc) {
+            io_queue_depth = max<size_t>(1, stoul(argv[++i]));
+        } else if (arg == "--via-dual") {
+            via_dual = true;
+        } else if (arg == "--estimate") {
+            estimate = true;
+        } else if (arg == "--estimate-samples" && i + 1 < argc) {
+            estimate = true;
+            estimate_samples = max<size_t>(1, stoul(argv[++i]));
+        } else if (arg == "--numa") {
+            numa_aware = true;
+        } else if (arg == "--huge-pages") {
+            numa_aware = true;
+            huge_pages = true;
+        } else if (arg == "--perf-counters") {
+            perf_counters = true;
+        } else if (arg == "--carry-flats") {
+            carry_flats = true;
+        } else if (arg == "--exclude-minors" && i + 1 < argc) {
+            if (!read_excluded_minors(argv[++i])) return 1;
+        } else if (arg == "--no-early-pruning") {
+            early_pruning = false;
+        } else if (arg == "--longest-first") {
+            schedule_longest_first = true;
+        } else if (arg == "--cost-report" && i + 1 < argc) {
+            cost_report = argv[++i];
+        } else if (arg == "--resume") {
+            resume = true;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_interval = chrono::seconds(stoul(argv[++i]));
+        } else if (arg.find_first_not_of("0123456789") == string::npos) {
+            num_threads = stoi(arg);
         } else {
-            num_threads = stoi(argv[i]);
+            usage(argv[0]);
+            return 1;
         }
     }
     omp_set_num_threads(num_threads);
+    if (perf_counters) perf = make_unique<PerfReport>(num_threads);
+
+    if (num_shards == 0 || shard_index >= num_shards ||
+        (num_shards > 1 && !to_file && !census)) {
+        cerr << "Sharding requires 0 <= i < k and --file, --compressed-file "
+                "or --census"
+             << endl;
+        return 1;
+    }
+
+    if (merge) return merge_shards(r, n) ? 0 : 1;
+
+    if (!excluded_minors.empty() && (estimate || via_dual)) {
+        cerr << "--exclude-minors cannot be combined with --estimate or "
+                "--via-dual"
+             << endl;
+        return 1;
+    }
 
-    if (to_file) open_files(r, n, num_threads);
+    if (estimate) {
+        IC_estimate(r, n);
+        return 0;
+    }
+
+    if (census) {
+        visitor = make_unique<CensusVisitor>(r, n, num_threads);
+        to_file = false;
+    }
+
+    // Duality does not preserve simplicity or the paving property
+    via_dual = via_dual && 2 * r > n && r < n;
+    if (via_dual && (simple_only || paving_only)) {
+        cerr << "--via-dual cannot be combined with --simple or --paving"
+             << endl;
+        return 1;
+    }
+
+    if (resume && !to_file) {
+        cerr << "--resume requires --file or --compressed-file" << endl;
+        return 1;
+    }
+
+    // Thread files written out of index order are merged by seeking, which
+    // needs plain text
+    compress_thread_files =
+        use_compression && !schedule_longest_first && !numa_aware;
+
+    if (resume && !resume_files(r, n)) return 1;
+    if (to_file && !open_files(r, n, num_threads)) return 1;
+
+    if (show_progress || !stats_filename.empty())
+        progress = make_unique<Progress>(num_threads, show_progress,
+                                         stats_filename, PROGRESS_INTERVAL);
+
+    if (numa_aware) numa = make_unique<NumaTables>(num_threads);
 
     // Main IC call
-    IC(r, n);
+    if (via_dual) {
+        if (progress) progress->attach(0);
+        IC_via_dual(r, n);
+    } else {
+        IC(r, n);
+    }
+
+    if (progress) progress->finish();
+    if (perf) perf->print(cerr);
 
-    if (to_file) merge_files();
+    if (to_file) merge_files(r, n);
+    if (visitor) visitor->finish();
 
     return 0;
 }
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t IO_BUFFER_SIZE = 1 << 20;  // bytes per write request
+constexpr size_t IO_ALIGNMENT = 4096;
+constexpr off_t IO_PREALLOCATION = 64 << 20;  // step of file preallocation
+
+inline bool async_io = false;      // write thread files through IOQueue
+inline size_t io_queue_depth = 8;  // maximum number of pending requests
+
+class AsyncFileBuf;
+
+// A dedicated thread performing the writes of all AsyncFileBufs in the order
+// of submission, so that the threads filling the buffers only block when
+// io_queue_depth requests are pending
+class IOQueue {
+   private:
+    struct Request {
+        AsyncFileBuf* file;
+        char* data;
+        size_t size;
+        off_t offset;
+    };
+
+    deque<Request> requests;
+    vector<char*> free_buffers;
+    vector<char*> buffers;  // all allocated
+    mutex m;
+    condition_variable cv;
+    thread worker;
+    bool stop = false;
+
+    void run();
+
+   public:
+    IOQueue() { worker = thread([this] { run(); }); }
+
+    ~IOQueue() {
+        {
+            lock_guard<mutex> lock(m);
+            stop = true;
+        }
+        cv.notify_all();
+        worker.join();
+        for (char* buffer : buffers) free(buffer);
+    }
+
+    static IOQueue& instance() {
+        static IOQueue queue;
+        return queue;
+    }
+
+    // An aligned buffer of IO_BUFFER_SIZE bytes
+    char* acquire() {
+        lock_guard<mutex> lock(m);
+        if (free_buffers.empty()) {
+            char* buffer = static_cast<char*>(
+                aligned_alloc(IO_ALIGNMENT, IO_BUFFER_SIZE));
+            buffers.push_back(buffer);
+            return buffers.back();
+        }
+        char* buffer = free_buffers.back();
+        free_buffers.pop_back();
+        return buffer;
+    }
+
+    void release(char* buffer) {
+        lock_guard<mutex> lock(m);
+        free_buffers.push_back(buffer);
+    }
+
+    // Write size bytes of the buffer at the offset of the file; the buffer is
+    // released once written
+    void submit(AsyncFileBuf* file, char* data, size_t size, off_t offset);
+
+    // Wait until the requests of the file are written
+    void wait(AsyncFileBuf* file);
+};
+
+// Output buffer of a file written at explicit offsets by IOQueue. Seeking
+// (e.g. by SZWriter) submits the current buffer.
+class AsyncFileBuf : public streambuf {
+   private:
+    friend class IOQueue;
+
+    int fd = -1;
+    off_t offset = 0;      // of the buffer in the file
+    size_t pending = 0;    // submitted requests (guarded by the queue)
+    off_t allocated = 0;   // preallocated size (of the I/O thread)
+    bool failed = false;   // a write failed (of the I/O thread)
+    string filename;
+    char* buffer = nullptr;
+
+    void submit() {
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        if (size == 0) return;
+        IOQueue::instance().submit(this, buffer, size, offset);
+        offset += static_cast<off_t>(size);
+        buffer = IOQueue::instance().acquire();
+        setp(buffer, buffer + IO_BUFFER_SIZE);
+    }
+
+    // Called by the I/O thread
+    void write_at(const char* data, size_t size, off_t at) {
+        off_t end = at + static_cast<off_t>(size);
+        if (end > allocated) {
+            allocated = end + IO_PREALLOCATION;
+            fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, allocated);
+        }
+        while (size > 0) {
+            ssize_t written = pwrite(fd, data, size, at);
+            if (written < 0) {
+                if (!failed) cerr << "Failed to write " << filename << endl;
+                failed = true;
+                return;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            at += written;
+        }
+    }
+
+   protected:
+    int_type overflow(int_type c) override {
+        submit();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    // Flushing waits until the file is written, e.g. before fsync
+    int sync() override {
+        submit();
+        IOQueue::instance().wait(this);
+        return failed ? -1 : 0;
+    }
+
+    pos_type seekoff(off_type off, ios_base::seekdir dir,
+                     ios_base::openmode which) override {
+        if (dir == ios_base::end) return pos_type(off_type(-1));
+        if (dir == ios_base::cur) {
+            off_type pos = offset + (pptr() - pbase());
+            if (off == 0) return pos_type(pos);  // tellp
+            off += pos;
+        }
+        return seekpos(pos_type(off), which);
+    }
+
+    pos_type seekpos(pos_type pos, ios_base::openmode) override {
+        submit();
+        offset = static_cast<off_t>(pos);
+        return pos;
+    }
+
+   public:
+    ~AsyncFileBuf() override { close(); }
+
+    bool open(const string& name) {
+        filename = name;
+        fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        buffer = IOQueue::instance().acquire();
+        setp(buffer, buffer + IO_BUFFER_SIZE);
+        return true;
+    }
+
+    void close() {
+        if (fd < 0) return;
+        sync();
+        ::close(fd);
+        fd = -1;
+        IOQueue::instance().release(buffer);
+        setp(nullptr, nullptr);
+    }
+};
+
+inline void IOQueue::run() {
+    unique_lock<mutex> lock(m);
+    while (true) {
+        cv.wait(lock, [this] { return stop || !requests.empty(); });
+        if (requests.empty()) return;
+        Request request = requests.front();
+        requests.pop_front();
+        cv.notify_all();
+        lock.unlock();
+        request.file->write_at(request.data, request.size, request.offset);
+        lock.lock();
+        free_buffers.push_back(request.data);
+        request.file->pending--;
+        cv.notify_all();
+    }
+}
+
+inline void IOQueue::submit(AsyncFileBuf* file, char* data, size_t size,
+                            off_t offset) {
+    unique_lock<mutex> lock(m);
+    cv.wait(lock, [this] { return requests.size() < io_queue_depth; });
+    requests.push_back({file, data, size, offset});
+    file->pending++;
+    cv.notify_all();
+}
+
+inline void IOQueue::wait(AsyncFileBuf* file) {
+    unique_lock<mutex> lock(m);
+    cv.wait(lock, [file] { return file->pending == 0; });
+}
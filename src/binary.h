@@ -0,0 +1,162 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Fixed-width binary format of colex strings, for consumers that mmap the file
+// and access record k in O(1):
+//   BinaryHeader
+//   SeedRange[seeds]   records generated from each seed, by seed index
+//   padding to a multiple of 64 bytes
+//   records            record_bytes each; bit j (byte j / 8, bit j % 8 from
+//                      the least significant) is 1 iff position j is '*'
+// All integers are little-endian.
+
+constexpr char BINARY_MAGIC[8] = {'I', 'C', 'B', 'I', 'N', '0', '0', '1'};
+
+struct BinaryHeader {
+    char magic[8];
+    uint16_t r;
+    uint16_t n;
+    uint32_t record_bits;   // C(n, r)
+    uint32_t record_bytes;  // ceil(record_bits / 8)
+    uint32_t reserved;
+    uint64_t records;
+    uint64_t seeds;
+    uint64_t seed_table_offset;
+    uint64_t records_offset;
+};
+static_assert(sizeof(BinaryHeader) == 56);
+
+struct SeedRange {
+    uint64_t index;  // of the seed matroid
+    uint64_t first;  // record
+    uint64_t count;
+};
+
+// Pack the first bits positions of a colex string into (bits + 7) / 8 bytes
+inline void pack_colex(const char* colex, size_t bits, uint8_t* record) {
+    memset(record, 0, (bits + 7) / 8);
+    for (size_t j = 0; j < bits; ++j)
+        if (colex[j] == '*') record[j / 8] |= static_cast<uint8_t>(1 << j % 8);
+}
+
+class BinaryWriter {
+   private:
+    ofstream file;
+    BinaryHeader header{};
+    vector<uint8_t> record;
+
+   public:
+    bool open(const string& filename, uint16_t r, uint16_t n,
+              uint32_t record_bits, const vector<SeedRange>& seeds) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) return false;
+        memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        header.r = r;
+        header.n = n;
+        header.record_bits = record_bits;
+        header.record_bytes = (record_bits + 7) / 8;
+        header.seeds = seeds.size();
+        header.seed_table_offset = sizeof(BinaryHeader);
+        header.records_offset =
+            (header.seed_table_offset + seeds.size() * sizeof(SeedRange) +
+             63) /
+            64 * 64;
+        record.resize(header.record_bytes);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(seeds.data()),
+                   static_cast<streamsize>(seeds.size() * sizeof(SeedRange)));
+        string padding(header.records_offset - header.seed_table_offset -
+                           seeds.size() * sizeof(SeedRange),
+                       '\0');
+        file.write(padding.data(), static_cast<streamsize>(padding.size()));
+        return true;
+    }
+
+    void write(const string& colex) {
+        pack_colex(colex.data(), header.record_bits, record.data());
+        file.write(reinterpret_cast<const char*>(record.data()),
+                   static_cast<streamsize>(record.size()));
+        header.records++;
+    }
+
+    void close() {
+        if (!file.is_open()) return;
+        // Update the record count in the header
+        file.seekp(0, ios::beg);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+    }
+
+    ~BinaryWriter() { close(); }
+};
+
+// Read-only mapping of a binary file
+class BinaryReader {
+   private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+   public:
+    const BinaryHeader* header = nullptr;
+
+    bool open(const string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 &&
+            static_cast<size_t>(st.st_size) >= sizeof(BinaryHeader)) {
+            size = static_cast<size_t>(st.st_size);
+            void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) data = static_cast<const uint8_t*>(p);
+        }
+        ::close(fd);
+        if (!data) return false;
+
+        header = reinterpret_cast<const BinaryHeader*>(data);
+        if (memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 ||
+            header->records_offset +
+                    header->records * header->record_bytes > size) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    const SeedRange* seeds() const {
+        return reinterpret_cast<const SeedRange*>(data +
+                                                  header->seed_table_offset);
+    }
+
+    const uint8_t* record(size_t k) const {
+        return data + header->records_offset + k * header->record_bytes;
+    }
+
+    string colex(size_t k) const {
+        const uint8_t* rec = record(k);
+        string s(header->record_bits, '0');
+        for (size_t j = 0; j < s.size(); ++j)
+            if (rec[j / 8] >> j % 8 & 1) s[j] = '*';
+        return s;
+    }
+
+    void close() {
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+        data = nullptr;
+        header = nullptr;
+    }
+
+    ~BinaryReader() { close(); }
+};
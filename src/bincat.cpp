@@ -0,0 +1,74 @@
+#include "binary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    bool info = false;
+    bool by_seed = false;
+    uint64_t seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0) {
+            info = true;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            by_seed = true;
+            seed = stoull(argv[++i]);
+        } else if (argv[i][0] == '-' || path) {
+            cerr << "usage: bincat <file> [options]\n"
+                 << "  Prints the colex strings of a binary file "
+                    "(IC --binary)\n"
+                 << "options:\n"
+                 << "  -i           print the header and the seed table\n"
+                 << "  -s <index>   print only the matroids of seed <index>\n";
+            return 1;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        cerr << "bincat: no input file specified\n";
+        return 1;
+    }
+
+    BinaryReader reader;
+    if (!reader.open(path)) {
+        cerr << "bincat: Failed to open " << path << '\n';
+        return 1;
+    }
+    const BinaryHeader& h = *reader.header;
+
+    if (info) {
+        cout << "r: " << h.r << "\nn: " << h.n
+             << "\nrecord bits: " << h.record_bits
+             << "\nrecord bytes: " << h.record_bytes
+             << "\nrecords: " << h.records << "\nseeds: " << h.seeds << '\n';
+        for (uint64_t i = 0; i < h.seeds; ++i) {
+            const SeedRange& s = reader.seeds()[i];
+            cout << s.index << " " << s.first << " " << s.count << '\n';
+        }
+        return 0;
+    }
+
+    uint64_t first = 0, count = h.records;
+    if (by_seed) {
+        // The seed table is sorted by seed index
+        const SeedRange* begin = reader.seeds();
+        const SeedRange* end = begin + h.seeds;
+        const SeedRange* s = lower_bound(
+            begin, end, seed,
+            [](const SeedRange& a, uint64_t index) { return a.index < index; });
+        if (s == end || s->index != seed) return 0;
+        first = s->first;
+        count = s->count;
+    }
+    for (uint64_t k = first; k < first + count; ++k)
+        cout << reader.colex(k) << '\n';
+    return 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "combinatorics.h"
+#include "matroid.h"
+#include "properties.h"
+#include "visitor.h"
+
+using namespace std;
+
+// Counts the generated matroids by invariants, without storing them
+class CensusVisitor : public Visitor {
+   private:
+    struct alignas(64) Counts {  // per thread
+        size_t all = 0;
+        size_t loopless = 0;
+        size_t coloopless = 0;
+        size_t simple = 0;
+        size_t connected = 0;
+        size_t paving = 0;
+        map<int64_t, size_t> bases;  // histogram of number of bases
+        vector<uint8_t> rank;        // buffer for the rank table
+    };
+
+    uint16_t r;
+    uint16_t n;
+    vector<bitset<N>> sets;
+    vector<Counts> counts;
+
+   public:
+    CensusVisitor(uint16_t r, uint16_t n, int threads)
+        : r(r), n(n), sets(combinations<N>(n, r)), counts(threads) {}
+
+    void visit(const Matroid& M, size_t, int tid) override {
+        Counts& c = counts[tid];
+        Properties p = compute_properties(r, n, M.colex, sets, c.rank);
+        c.all++;
+        c.loopless += p.loopless;
+        c.coloopless += p.coloopless;
+        c.simple += p.simple;
+        c.connected += p.connected;
+        c.paving += p.paving;
+        c.bases[p.T11]++;
+    }
+
+    void finish() override {
+        // Reduce into the counts of the first thread
+        Counts& total = counts[0];
+        for (size_t i = 1; i < counts.size(); ++i) {
+            total.all += counts[i].all;
+            total.loopless += counts[i].loopless;
+            total.coloopless += counts[i].coloopless;
+            total.simple += counts[i].simple;
+            total.connected += counts[i].connected;
+            total.paving += counts[i].paving;
+            for (auto [b, cnt] : counts[i].bases) total.bases[b] += cnt;
+        }
+
+        cout << "{\n"
+             << "  \"all\": " << total.all << ",\n"
+             << "  \"loopless\": " << total.loopless << ",\n"
+             << "  \"coloopless\": " << total.coloopless << ",\n"
+             << "  \"simple\": " << total.simple << ",\n"
+             << "  \"connected\": " << total.connected << ",\n"
+             << "  \"paving\": " << total.paving << ",\n"
+             << "  \"bases\": {";
+        bool first = true;
+        for (auto [b, cnt] : total.bases) {
+            cout << (first ? "\n" : ",\n") << "    \"" << b << "\": " << cnt;
+            first = false;
+        }
+        cout << "\n  }\n}" << endl;
+    }
+};
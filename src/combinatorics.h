@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,10 +17,11 @@ inline uint16_t bnml;          // C(n, r)
 inline uint16_t bnml_nm1;      // C(n - 1, r)
 inline uint16_t bnml_nm1_rm1;  // C(n - 1, r - 1)
 
-inline uint16_t* P;  // representatives (an ordered choice of
-                     // the first r elements)
-inline uint16_t* T;  // relative transpositions of representatives (action
-                     // on colex of the order of the rest n - r elements)
+inline uint16_t* P = nullptr;  // representatives (an ordered choice of
+                               // the first r elements)
+inline uint16_t* T = nullptr;  // relative transpositions of representatives
+                               // (action on colex of the order of the rest
+                               // n - r elements)
 
 inline vector<size_t> f;      // factorials (shifted by one)
 inline vector<uint16_t> C_r;  // binomials choose r (reversed)
@@ -29,6 +31,26 @@ inline vector<bitset<N>> index_to_set;  // index to set from C([n], r)
 
 inline vector<size_t> r_set_to_perm_reps;  // all perm reps, grouped by r-set
 
+// The tables read by the canonicity tests of the current thread: replicas of
+// P, T and r_set_to_perm_reps on its NUMA node (see numa.h), if set
+struct TableReplica {
+    const uint16_t* P = nullptr;
+    const uint16_t* T = nullptr;
+    const size_t* r_set_to_perm_reps = nullptr;
+};
+inline thread_local TableReplica thread_tables;
+
+inline const uint16_t* local_P() {
+    return thread_tables.P ? thread_tables.P : P;
+}
+inline const uint16_t* local_T() {
+    return thread_tables.T ? thread_tables.T : T;
+}
+inline const size_t* local_perm_reps() {
+    return thread_tables.r_set_to_perm_reps ? thread_tables.r_set_to_perm_reps
+                                            : r_set_to_perm_reps.data();
+}
+
 template <uint16_t N>
 struct CoLexComparator {
     bool operator()(const bitset<N>& a, const bitset<N>& b) const {
@@ -76,6 +98,19 @@ inline size_t factorial(uint16_t n) {
     return n * factorial(n - 1);
 }
 
+// k-th permutation of [n] in lexicographic order (as by next_permutation)
+inline vector<uint16_t> nth_permutation(uint16_t n, size_t k) {
+    vector<uint16_t> rest(n), perm;
+    for (uint16_t i = 0; i < n; ++i) rest[i] = i;
+    for (uint16_t i = n; i > 0; --i) {
+        size_t block = factorial(i - 1);
+        perm.push_back(rest[k / block]);
+        rest.erase(rest.begin() + static_cast<ptrdiff_t>(k / block));
+        k %= block;
+    }
+    return perm;
+}
+
 inline uint16_t binomial(size_t n, size_t k) {
     if (k == 0 || k == n) return 1;
     size_t res = 1;
@@ -85,6 +120,26 @@ inline uint16_t binomial(size_t n, size_t k) {
     return static_cast<uint16_t>(res);
 }
 
+// Allocate the tables used by initialize_combinatorics(n', r') for all
+// n' <= n and r' <= r encountered by the recursion (n - 1, r), (n - 1, r - 1)
+inline void allocate_combinatorics(uint16_t n, uint16_t r) {
+    delete[] P;
+    delete[] T;
+    P = new uint16_t[binomial(n, r) * factorial(r) * binomial(n, r)];
+    T = new uint16_t[factorial(n - r) * binomial(n, r)];
+    index_to_set.resize(binomial(n, r));
+    f.resize(n + 1);
+    C_r.resize(n + 2);
+    r_set_to_perm_reps.resize(binomial(n, r) * factorial(r));
+}
+
+inline void free_combinatorics() {
+    delete[] P;
+    delete[] T;
+    P = nullptr;
+    T = nullptr;
+}
+
 inline void initialize_combinatorics(uint16_t n, uint16_t r) {
     // Initialize factorial array
     for (uint16_t i = 1; i <= n; ++i) {
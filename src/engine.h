@@ -0,0 +1,190 @@
+#pragma once
+
+#include <omp.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+#include "extension.h"
+#include "matroid.h"
+#include "minors.h"
+#include "stats.h"
+
+using namespace std;
+
+// The recursion of IC, shared by build/IC and build/libmatroid.so. Each adds
+// its output, scheduling and reporting through a Driver, so that both
+// generate the same matroids under --simple, --paving, --carry-flats and
+// --exclude-minors.
+
+inline bool carry_flats = false;  // derive the flats of the seeds from parents
+
+// Extends the seed with the given index on thread tid
+using ExtendSeed = function<void(size_t index, int tid)>;
+
+// Hooks of IC_generate(). The top level is the requested (r, n), whose
+// matroids are passed to emit; the lower levels are generated whole.
+class Driver {
+   public:
+    virtual ~Driver() = default;
+
+    // Whether the top-level seed with this index (the number of seeds for the
+    // coloop extensions) is extended
+    virtual bool pending(size_t /*index*/) { return true; }
+
+    // Reorder the pending top-level seeds of IC_nm1
+    virtual void schedule(uint16_t /*r*/, uint16_t /*n*/,
+                          const vector<string>& /*IC_nm1*/,
+                          vector<size_t>& /*order*/) {}
+
+    // Called at each level after the tables are initialized, with the number
+    // of seeds to extend (the coloop extensions count as one), and at its end
+    virtual void begin_level(uint16_t /*r*/, uint16_t /*n*/,
+                             size_t /*seeds*/) {}
+    virtual void end_level(bool /*top_level*/) {}
+
+    // Extend the seeds in the given order, by default on the OpenMP threads
+    virtual void extend(const vector<size_t>& order, bool /*top_level*/,
+                        const ExtendSeed& extend_seed) {
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t k = 0; k < order.size(); ++k)
+            extend_seed(order[k], omp_get_thread_num());
+    }
+
+    // Receives the top-level matroids with the index of their seed, called
+    // concurrently from the threads of extend
+    virtual void emit(const Matroid& M, size_t index, int tid) = 0;
+
+    // Called after all matroids of a top-level seed are emitted, with the
+    // seconds spent extending it
+    virtual void seed_done(size_t /*index*/, int /*tid*/,
+                           double /*seconds*/) {}
+
+    // Whether to skip the remaining top-level coloop extensions
+    virtual bool stopped() { return false; }
+};
+
+// The canonical (r, n) matroids, in the order of the output of IC. At the top
+// level they are passed to driver.emit and only a base case is returned. If
+// flats is set, it receives the flats of each matroid that could be derived
+// from its parent.
+inline vector<string> IC_generate(uint16_t r, uint16_t n, Driver& driver,
+                                  bool top_level = true,
+                                  vector<Flats>* flats = nullptr) {
+    // Base cases
+    if (n < r) {
+        return {};
+    } else if (r == 0 || n == r) {
+        // The n loops of rank 0 are not simple
+        if (simple_only && r == 0 && n > 0) return {};
+        if (has_excluded_minor(r, n, "*", n)) return {};
+        if (flats) flats->assign(1, Flats());
+        Matroid M(r, n, "*");
+        if (top_level && driver.pending(0)) {
+            driver.emit(M, 0, 0);
+            driver.seed_done(0, 0, 0);
+        }
+        return {M.colex};
+    }
+
+    if (top_level) {
+        // These sizes suffice because the recursive calls are
+        // (n - 1, r) and (n - 1, r - 1)
+        allocate_combinatorics(n, r);
+    }
+
+    // Recursive calls
+    vector<Flats> flats_nm1, flats_rm1_nm1;
+    vector<string> IC_nm1 = IC_generate(r, n - 1, driver, false,
+                                        carry_flats ? &flats_nm1 : nullptr);
+    vector<string> IC_rm1_nm1 = IC_generate(r - 1, n - 1, driver, false,
+                                            flats ? &flats_rm1_nm1 : nullptr);
+
+    // Initialize factorials, binomial coefficients,
+    // mappings between indices and sets,
+    // and fill permutation array of size n! * C(n, r)
+    initialize_combinatorics(n, r);
+
+    // Indices of the seeds of IC_nm1 in the order of processing
+    vector<size_t> order;
+    for (size_t i = 0; i < IC_nm1.size(); ++i)
+        if (!top_level || driver.pending(i)) order.push_back(i);
+    const bool coloops = !top_level || driver.pending(IC_nm1.size());
+    if (top_level) driver.schedule(r, n, IC_nm1, order);
+
+    // The coloop extensions of IC_rm1_nm1 count as one seed
+    driver.begin_level(r, n, order.size() + coloops);
+
+    // Process IC_nm1
+    vector<string> matroids;
+    vector<vector<string>> local_matroids(!top_level ? IC_nm1.size() : 0);
+    vector<vector<Flats>> local_flats(flats ? IC_nm1.size() : 0);
+    driver.extend(order, top_level, [&](size_t i, int tid) {
+        auto seed_start = chrono::steady_clock::now();
+        Matroid M(r, n - 1, IC_nm1[i]);
+        if (!flats_nm1.empty()) M.flats = move(flats_nm1[i]);
+        DeriveChildFlats derive(flats != nullptr);
+        // Iterate over all canonical extensions
+        M.canonical_extensions([&](Matroid M_ext) {
+            // The seed has no excluded minor
+            if (has_excluded_minor(r, n, M_ext.colex, n - 1)) return;
+            if (top_level) {
+                driver.emit(M_ext, i, tid);
+            } else {
+                local_matroids[i].push_back(M_ext.colex);
+                if (flats) local_flats[i].push_back(move(M_ext.flats));
+            }
+            if (thread_stats) bump(thread_stats->extensions);
+        });
+        auto seed_time = chrono::steady_clock::now() - seed_start;
+        if (top_level)
+            driver.seed_done(i, tid,
+                             chrono::duration<double>(seed_time).count());
+        if (thread_stats) {
+            bump(thread_stats->seeds);
+            bump(thread_stats->busy_ns, seed_time / 1ns);
+        }
+    });
+
+    for (auto& v : local_matroids) {
+        matroids.insert(matroids.end(), make_move_iterator(v.begin()),
+                        make_move_iterator(v.end()));
+    }
+    for (auto& v : local_flats) {
+        flats->insert(flats->end(), make_move_iterator(v.begin()),
+                      make_move_iterator(v.end()));
+    }
+
+    // Process IC_rm1_nm1 (seed index IC_nm1.size() for sharding)
+    if (coloops) {
+        for (size_t k = 0; k < IC_rm1_nm1.size(); ++k) {
+            if (top_level && driver.stopped()) break;
+            const string& colex = IC_rm1_nm1[k];
+            // A coloop is added to a paving matroid only if its circuits
+            // have size r, i.e. it is uniform
+            if (paving_only && colex.find('0') != string::npos) continue;
+            Matroid M(r - 1, n - 1, colex);
+            if (!flats_rm1_nm1.empty()) M.flats = move(flats_rm1_nm1[k]);
+            Matroid M_ext = M.coloop_extension();
+            if (has_excluded_minor(r, n, M_ext.colex, n - 1)) continue;
+            if (top_level) {
+                driver.emit(M_ext, IC_nm1.size(), 0);
+            } else {
+                matroids.push_back(move(M_ext.colex));
+                if (flats) flats->push_back(move(M_ext.flats));
+            }
+            if (thread_stats) bump(thread_stats->extensions);
+        }
+        if (top_level) driver.seed_done(IC_nm1.size(), 0, 0);
+        if (thread_stats) bump(thread_stats->seeds);
+    }
+    driver.end_level(top_level);
+
+    return matroids;
+}
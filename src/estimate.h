@@ -0,0 +1,295 @@
+#pragma once
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "extension.h"
+#include "matroid.h"
+#include "sz.h"
+
+using namespace std;
+
+inline size_t estimate_samples = 200;  // seeds sampled by --estimate
+constexpr size_t PILOT_WALKS = 32;      // random DFS paths to size a seed
+constexpr size_t ESTIMATE_WALKS = 256;  // random DFS paths per large seed
+// Sampled seeds whose DFS has fewer estimated nodes are extended exactly
+constexpr double EXACT_NODES = 4096;
+// Canonical extensions have few new non-bases, so walks include a hyperplane
+// with less probability than they exclude it
+constexpr double INCLUDE_PROBABILITY = 0.2;
+constexpr uint64_t ESTIMATE_RNG_SEED = 1;
+constexpr double Z_95 = 1.96;
+
+// Estimates for the extensions of one seed matroid
+struct SeedEstimate {
+    bool exact = false;     // extended by traverse_linear_subclasses
+    double extensions = 0;  // canonical
+    double variance = 0;    // of the estimate of extensions
+    double modelled = 0;    // seconds of dfs_search, from the walks
+    double seconds = 0;     // measured, if exact
+    double sz_bits = 0;     // of the lines after the first, if exact
+    size_t walks = 0;       // random paths taken
+};
+
+// Sums over random root-to-leaf paths of the DFS of dfs_search
+struct Walks {
+    size_t walks = 0;
+    size_t visited = 0;        // nodes
+    double nodes = 0;          // estimated, summed over the walks
+    double leaves = 0;         // estimated
+    double sum = 0;            // of the estimates of canonical extensions
+    double sum_sq = 0;
+    double seconds = 0;        // of the walks
+    double check_seconds = 0;  // of their canonicity tests
+};
+
+// Knuth's estimator of the DFS of dfs_search: a random path from the root
+// descends into one of the children of each node (excluding or, if possible,
+// including its first free hyperplane). The product of the inverse
+// probabilities of the choices along the path is an unbiased estimate of the
+// number of nodes at each depth, and at the leaf of the number of leaves. The
+// walks take no shortcut, so they model the cost of dfs_search from above.
+inline void walk(const Node& first_node, const string& base_colex_ext,
+                 mt19937_64& rng, Walks& w) {
+    using clock = chrono::steady_clock;
+    auto start = clock::now();
+    const Matroid& M = *first_node.M;
+    Node node(first_node), include_node(first_node);
+    double weight = 1;
+    w.nodes += 1;
+    w.visited++;
+    size_t p;
+    while ((p = node.p_free._Find_first()) != N_H) {
+        include_node = node;
+        bool include = include_node.insert_plane(p) &&
+                       !(simple_only && include_node.has_parallel());
+        if (include && bernoulli_distribution(INCLUDE_PROBABILITY)(rng)) {
+            weight /= INCLUDE_PROBABILITY;
+            node = include_node;
+        } else {
+            if (include) weight /= 1 - INCLUDE_PROBABILITY;
+            node.remove_plane(p);
+        }
+        w.nodes += weight;
+        w.visited++;
+    }
+    w.walks++;
+    w.leaves += weight;
+    auto check_start = clock::now();
+    string M_ext = M.colex + extend_matroid_LS(node, base_colex_ext);
+    if (is_canonical_extension(M_ext.data(), M.r, M.n + 1) == bnml) {
+        w.sum += weight;
+        w.sum_sq += weight * weight;
+    }
+    w.check_seconds +=
+        chrono::duration<double>(clock::now() - check_start).count();
+    w.seconds += chrono::duration<double>(clock::now() - start).count();
+}
+
+// Extend M exactly if the first walks estimate a small DFS, else estimate its
+// extensions by walks
+inline SeedEstimate sample_extensions(const Matroid& M, mt19937_64& rng) {
+    SeedEstimate e;
+    string base_colex_ext = init_search(M, true);
+    Node first_node = root_node(M, true);
+    if (simple_only && first_node.has_parallel()) {
+        e.exact = true;
+        return e;
+    }
+
+    Walks w;
+    while (w.walks < PILOT_WALKS) walk(first_node, base_colex_ext, rng, w);
+    bool exact = w.nodes / PILOT_WALKS <= EXACT_NODES;
+    while (!exact && w.walks < ESTIMATE_WALKS)
+        walk(first_node, base_colex_ext, rng, w);
+    e.walks = w.walks;
+
+    double k = static_cast<double>(w.walks);
+    e.extensions = w.sum / k;
+    // At least the variance of a single canonical leaf of the mean weight, as
+    // the walks may miss rare canonical leaves altogether
+    e.variance = max({0.0,
+                      (w.sum_sq / k - e.extensions * e.extensions) / (k - 1),
+                      w.leaves * w.leaves / (k * k * k * k)});
+    // Seconds per node and per canonicity test, as measured on the walks
+    e.modelled = (w.seconds - w.check_seconds) /
+                     static_cast<double>(w.visited) * w.nodes / k +
+                 w.check_seconds / k * w.leaves / k;
+    if (!exact) return e;
+
+    // Small enough to extend exactly, also measuring the .sz encoding
+    e.exact = true;
+    e.extensions = e.variance = 0;
+    string prev;
+    auto on_extension = [&](const Matroid& M_ext) {
+        if (!prev.empty()) {
+            size_t diffs = 0;
+            for (size_t i = 0; i < prev.size(); ++i)
+                diffs += prev[i] != M_ext.colex[i];
+            e.sz_bits += static_cast<double>((diffs + 1) * bits_for(bnml));
+        }
+        prev = M_ext.colex;
+        e.extensions++;
+    };
+    auto start = chrono::steady_clock::now();
+    Matroid M_exact(M.r, M.n, M.colex);  // the tables of M are initialized
+    traverse_linear_subclasses(M_exact, true, on_extension);
+    e.seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return e;
+}
+
+// Estimate of a sum over all seeds from a sample of them: the sample mean
+// times the number of seeds, and the variance of that estimate (of sampling
+// seeds without replacement, plus the variance of the per-seed estimates)
+struct Total {
+    double value = 0;
+    double variance = 0;
+
+    double low() const { return max(0.0, value - Z_95 * sqrt(variance)); }
+    double high() const { return value + Z_95 * sqrt(variance); }
+};
+
+inline Total estimate_total(const vector<double>& x,
+                            const vector<double>& variance, size_t seeds) {
+    Total t;
+    double k = static_cast<double>(x.size());
+    double s = static_cast<double>(seeds);
+    if (x.empty()) return t;
+    double mean = accumulate(x.begin(), x.end(), 0.0) / k;
+    double ss = 0;
+    for (double v : x) ss += (v - mean) * (v - mean);
+    t.value = s * mean;
+    if (x.size() > 1) t.variance = s * s * (1 - k / s) * ss / (k - 1) / k;
+    for (double v : variance) t.variance += s * s / (k * k) * v;
+    return t;
+}
+
+// Peak resident memory of the process in bytes
+inline double peak_memory() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) * 1024;
+}
+
+// CPU seconds of the process so far
+inline double cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec +
+                               usage.ru_stime.tv_usec) /
+               1e6;
+}
+
+// Estimate the run of IC(r, n) from its seeds IC_nm1, given the number of
+// coloop extensions and the CPU seconds spent on the lower levels, and print
+// the estimates as JSON
+inline void estimate_level(uint16_t r, uint16_t n, const vector<string>& IC_nm1,
+                           size_t coloop_extensions, double lower_seconds) {
+    auto start = chrono::steady_clock::now();
+
+    // Sample seeds without replacement
+    vector<size_t> sample(IC_nm1.size());
+    iota(sample.begin(), sample.end(), 0);
+    mt19937_64 rng(ESTIMATE_RNG_SEED);
+    size_t k = min(estimate_samples, sample.size());
+    for (size_t i = 0; i < k; ++i)
+        swap(sample[i], sample[i + rng() % (sample.size() - i)]);
+    sample.resize(k);
+    sort(sample.begin(), sample.end());
+
+    vector<SeedEstimate> estimates(k);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < k; ++i) {
+        mt19937_64 seed_rng(ESTIMATE_RNG_SEED + sample[i]);
+        estimates[i] =
+            sample_extensions(Matroid(r, n - 1, IC_nm1[sample[i]]), seed_rng);
+    }
+
+    // The walks overestimate the cost of dfs_search: scale their model by
+    // the measured time of the exact seeds
+    double measured = 0, modelled = 0, lines = 0, sz_bits = 0;
+    size_t walks = 0;
+    for (const SeedEstimate& e : estimates) {
+        walks += e.walks;
+        if (!e.exact) continue;
+        measured += e.seconds;
+        modelled += e.modelled;
+        lines += max(e.extensions - 1, 0.0);
+        sz_bits += e.sz_bits;
+    }
+    double scale = modelled > 0 ? measured / modelled : 1;
+    vector<double> counts, count_variances, seconds;
+    for (const SeedEstimate& e : estimates) {
+        counts.push_back(e.extensions);
+        count_variances.push_back(e.variance);
+        seconds.push_back(e.exact ? e.seconds : e.modelled * scale);
+    }
+    Total matroids = estimate_total(counts, count_variances, IC_nm1.size());
+    matroids.value += static_cast<double>(coloop_extensions);
+    Total top_seconds = estimate_total(seconds, {}, IC_nm1.size());
+
+    // Bits per line of the .sz file, from the consecutive extensions of the
+    // exact seeds or else from the seeds
+    double line_bits = 0;
+    if (lines > 0) {
+        line_bits = sz_bits / lines;
+    } else if (IC_nm1.size() > 1) {
+        for (size_t i = 1; i < IC_nm1.size(); ++i) {
+            size_t diffs = 0;
+            for (size_t j = 0; j < IC_nm1[i].size(); ++j)
+                diffs += IC_nm1[i][j] != IC_nm1[i - 1][j];
+            line_bits += static_cast<double>(diffs + 1);
+        }
+        line_bits *= bits_for(bnml) / static_cast<double>(IC_nm1.size() - 1);
+    }
+    auto sz_bytes = [&](double count) {
+        if (count < 1) return 0.0;
+        return 12 + static_cast<double>(bnml) + (count - 1) * line_bits / 8;
+    };
+    auto text_bytes = [&](double count) {
+        return count * static_cast<double>(bnml + 1);
+    };
+    auto hours = [&](double s) { return (lower_seconds + s) / 3600; };
+    size_t exact = static_cast<size_t>(
+        count_if(estimates.begin(), estimates.end(),
+                 [](const SeedEstimate& e) { return e.exact; }));
+    double elapsed =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << fixed << setprecision(0) << "{\n"
+         << "  \"r\": " << r << ",\n"
+         << "  \"n\": " << n << ",\n"
+         << "  \"seeds\": " << IC_nm1.size() << ",\n"
+         << "  \"sampled_seeds\": " << k << ",\n"
+         << "  \"exact_seeds\": " << exact << ",\n"
+         << "  \"walks\": " << walks << ",\n"
+         << "  \"matroids\": " << matroids.value << ",\n"
+         << "  \"matroids_ci95\": [" << matroids.low() << ", "
+         << matroids.high() << "],\n"
+         << "  \"text_bytes\": " << text_bytes(matroids.value) << ",\n"
+         << "  \"text_bytes_ci95\": [" << text_bytes(matroids.low()) << ", "
+         << text_bytes(matroids.high()) << "],\n"
+         << "  \"sz_bytes\": " << sz_bytes(matroids.value) << ",\n"
+         << "  \"sz_bytes_ci95\": [" << sz_bytes(matroids.low()) << ", "
+         << sz_bytes(matroids.high()) << "],\n"
+         << "  \"peak_memory_bytes\": " << peak_memory() << ",\n"
+         << setprecision(6)
+         << "  \"cpu_hours\": " << hours(top_seconds.value) << ",\n"
+         << "  \"cpu_hours_ci95\": [" << hours(top_seconds.low()) << ", "
+         << hours(top_seconds.high()) << "],\n"
+         << setprecision(3) << "  \"estimate_seconds\": " << elapsed << "\n"
+         << "}" << endl;
+}
@@ -3,15 +3,46 @@
 #include <bitset>
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "combinatorics.h"
 #include "matroid.h"
+#include "perf.h"
+#include "stats.h"
 
 using namespace std;
 
+// Restrictions of the generated matroids to classes closed under deletion, so
+// that the seeds of IC() can be restricted as well
+inline bool simple_only = false;  // no loops or parallel elements
+inline bool paving_only = false;  // no circuits of size less than r
+
+inline bool early_pruning = true;  // canonicity tests at internal DFS nodes
+
+// Whether the canonical extensions of the thread's seed get their flats
+// derived (to be extended in turn)
+inline thread_local bool derive_child_flats = false;
+
+// Sets derive_child_flats on the thread for the extensions of one seed
+struct DeriveChildFlats {
+    explicit DeriveChildFlats(bool derive) { derive_child_flats = derive; }
+    ~DeriveChildFlats() { derive_child_flats = false; }
+};
+
+// A (partial) permutation under which a colex string failed the canonicity
+// test, determined on the positions [0, end)
+struct Witness {
+    const uint16_t* P_row = nullptr;
+    const uint16_t* T_row = nullptr;
+    uint16_t end = 0;
+};
+
+// Witness of the last failed canonicity test of the current thread
+inline thread_local Witness last_witness;
+
 inline uint16_t dfs_canonical(const char* colex, const size_t unset,
                               const uint16_t* P_row, const uint16_t* T_row) {
     // The variable `unset` stores the number of undetermined positions at the
@@ -23,6 +54,7 @@ inline uint16_t dfs_canonical(const char* colex, const size_t unset,
     for (uint16_t j = C_r[unset + 1]; j < C_r[unset]; ++j) {
         if (colex[P_row[T_row[j]]] != colex[j]) {
             if (colex[j] == '*') {
+                last_witness = {P_row, T_row, C_r[unset]};
                 return j;  // Not canonical
             }
             return bnml;  // Prune
@@ -49,16 +81,19 @@ inline uint16_t is_canonical(const char* colex, size_t r, size_t n) {
     // Return first detected position of failure ('*' -> '0'),
     // or bnml if no such position exists (canonical)
     // Main check: traverse (partial) permutations using DFS
+    const uint16_t* P_local = local_P();
+    const uint16_t* T_local = local_T();
+    const size_t* perm_reps = local_perm_reps();
     for (size_t r_set_idx = 0; r_set_idx < bnml; ++r_set_idx) {
         if (colex[r_set_idx] != '0') {
             continue;
         }
         for (size_t i = 0; i < f[r + 1]; ++i) {
-            size_t perm_rep = r_set_to_perm_reps[r_set_idx * f[r + 1] + i];
-            uint16_t* P_row = P + perm_rep * bnml;
+            size_t perm_rep = perm_reps[r_set_idx * f[r + 1] + i];
+            const uint16_t* P_row = P_local + perm_rep * bnml;
             for (size_t j = 0; j < n - r; ++j) {
                 uint16_t j_fail = dfs_canonical(colex, n - r - 1, P_row,
-                                                T + j * f[n - r] * bnml);
+                                                T_local + j * f[n - r] * bnml);
                 if (j_fail != bnml) return j_fail;
             }
         }
@@ -67,6 +102,202 @@ inline uint16_t is_canonical(const char* colex, size_t r, size_t n) {
     return bnml;
 }
 
+// A branch of the canonicity test of the extensions of a seed matroid that is
+// not decided by the common prefix (the colex string of the seed): the test
+// continues with dfs_canonical(colex, unset, P_row, T_row) if r-set r_set_idx
+// is a non-basis, or fails at j_fail if it is set
+struct PrefixBranch {
+    uint16_t r_set_idx;
+    uint16_t unset;
+    uint16_t j_fail;
+    const uint16_t* P_row;
+    const uint16_t* T_row;
+};
+
+// Maximum number of branches kept per seed, beyond which the leaves fall back
+// to is_canonical
+constexpr size_t MAX_PREFIX_BRANCHES = 1 << 16;
+
+struct PrefixBranches {
+    bool valid = false;
+    vector<PrefixBranch> branches;  // in the order of is_canonical
+    size_t automorphisms = 0;  // of the seed (fixing the new element)
+};
+
+// Branches of the seed matroid currently extended by the thread
+inline thread_local PrefixBranches prefix_branches;
+
+inline bool dfs_prefix_branches(const string& prefix, uint16_t r_set_idx,
+                                size_t unset, const uint16_t* P_row,
+                                const uint16_t* T_row, PrefixBranches& B) {
+    // Same traversal as dfs_canonical over the positions of the prefix. A
+    // branch is kept at the first position compared with one of the suffix.
+    // Returns whether the traversal continues.
+    auto keep = [&](uint16_t j_fail) {
+        B.branches.push_back({r_set_idx, static_cast<uint16_t>(unset), j_fail,
+                              P_row, T_row});
+        B.valid = B.branches.size() <= MAX_PREFIX_BRANCHES;
+        // A failure for all extensions ends the test, unless its r-set is
+        // only a non-basis for some of them
+        return B.valid && (j_fail == bnml || r_set_idx >= bnml_nm1);
+    };
+    // Only the suffix is left: sigma fixes the new element
+    if (unset == 0) {
+        if (r_set_idx < bnml_nm1) B.automorphisms++;
+        return keep(bnml);
+    }
+
+    for (uint16_t j = C_r[unset + 1]; j < C_r[unset]; ++j) {
+        uint16_t pos = P_row[T_row[j]];
+        if (pos >= bnml_nm1) return keep(bnml);
+        if (prefix[pos] != prefix[j]) {
+            if (prefix[j] == '*') return keep(j);  // Not canonical
+            return true;                           // Prune
+        }
+    }
+
+    for (size_t i = 0; i < unset; ++i) {
+        if (!dfs_prefix_branches(prefix, r_set_idx, unset - 1, P_row,
+                                 T_row + i * f[unset] * bnml, B)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Precompute the branches of the canonicity test that the colex string of M
+// leaves open for its extensions (tables of n + 1 elements)
+inline void init_prefix_branches(const Matroid& M, PrefixBranches& B) {
+    size_t r = M.r, n = M.n + 1;
+    B.valid = true;
+    B.branches.clear();
+    B.automorphisms = 0;
+    // The colex string of a uniform matroid has no non-basis to start with
+    if (M.colex.find('0') == string::npos) B.automorphisms = factorial(M.n);
+    const uint16_t* P_local = local_P();
+    const uint16_t* T_local = local_T();
+    const size_t* perm_reps = local_perm_reps();
+    for (size_t r_set_idx = 0; r_set_idx < bnml; ++r_set_idx) {
+        if (r_set_idx < bnml_nm1 && M.colex[r_set_idx] != '0') continue;
+        for (size_t i = 0; i < f[r + 1]; ++i) {
+            size_t perm_rep = perm_reps[r_set_idx * f[r + 1] + i];
+            const uint16_t* P_row = P_local + perm_rep * bnml;
+            for (size_t j = 0; j < n - r; ++j) {
+                if (!dfs_prefix_branches(M.colex,
+                                         static_cast<uint16_t>(r_set_idx),
+                                         n - r - 1, P_row,
+                                         T_local + j * f[n - r] * bnml, B)) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// is_canonical for an extension of the seed matroid of prefix_branches
+inline uint16_t is_canonical_extension(const char* colex, size_t r,
+                                       size_t n) {
+    if (!prefix_branches.valid) return is_canonical(colex, r, n);
+    for (const PrefixBranch& b : prefix_branches.branches) {
+        if (colex[b.r_set_idx] != '0') continue;
+        if (b.j_fail != bnml) {
+            last_witness = {b.P_row, b.T_row, C_r[b.unset]};
+            return b.j_fail;
+        }
+        uint16_t j_fail = dfs_canonical(colex, b.unset, b.P_row, b.T_row);
+        if (j_fail != bnml) return j_fail;
+    }
+    return bnml;
+}
+
+struct CanonicalSearch {
+    const char* colex;
+    string best;  // lexicographically maximal relabelling found so far
+    size_t best_P_row = 0;
+    size_t best_T_row = 0;
+};
+
+inline bool dfs_canonicalize(CanonicalSearch& S, const size_t unset,
+                             const uint16_t* P_row, const uint16_t* T_row,
+                             bool greater) {
+    // Same traversal as dfs_canonical, but branches are only pruned when the
+    // relabelled prefix is smaller than the best one. `greater` tells whether
+    // the prefix determined by the ancestors already beats S.best.
+    // Returns whether S.best was updated in this subtree.
+    if (!greater) {
+        for (uint16_t j = C_r[unset + 1]; j < C_r[unset]; ++j) {
+            if (S.colex[P_row[T_row[j]]] != S.best[j]) {
+                if (S.best[j] == '0') return false;  // Prune
+                greater = true;
+                break;
+            }
+        }
+    }
+
+    // Complete sigma checked
+    if (unset == 0) {
+        if (!greater) return false;
+        for (uint16_t j = 0; j < bnml; ++j) {
+            S.best[j] = S.colex[P_row[T_row[j]]];
+        }
+        S.best_P_row = static_cast<size_t>(P_row - P) / bnml;
+        S.best_T_row = static_cast<size_t>(T_row - T) / bnml;
+        return true;
+    }
+
+    bool updated = false;
+    for (size_t i = 0; i < unset; ++i) {
+        if (dfs_canonicalize(S, unset - 1, P_row, T_row + i * f[unset] * bnml,
+                             greater)) {
+            // S.best now shares the prefix determined so far
+            updated = true;
+            greater = false;
+        }
+    }
+    return updated;
+}
+
+inline string canonicalize(const char* colex, size_t r, size_t n,
+                           vector<uint16_t>* perm = nullptr) {
+    // Return the canonical (lexicographically maximal) relabelling of colex.
+    // If perm is given, it is set so that element e of the result corresponds
+    // to element (*perm)[e] of the input.
+    CanonicalSearch S{colex, string(colex, bnml)};
+    bool updated = false;
+    if (r > 0 && r < n) {
+        // As in is_canonical, the first r-set must be mapped to a '0'
+        for (size_t r_set_idx = 0; r_set_idx < bnml; ++r_set_idx) {
+            if (colex[r_set_idx] != '0') {
+                continue;
+            }
+            for (size_t i = 0; i < f[r + 1]; ++i) {
+                size_t perm_rep = r_set_to_perm_reps[r_set_idx * f[r + 1] + i];
+                uint16_t* P_row = P + perm_rep * bnml;
+                for (size_t j = 0; j < n - r; ++j) {
+                    if (dfs_canonicalize(S, n - r - 1, P_row,
+                                         T + j * f[n - r] * bnml,
+                                         S.best[0] != '0'))
+                        updated = true;
+                }
+            }
+        }
+    }
+
+    if (perm) {
+        perm->resize(n);
+        for (uint16_t e = 0; e < n; ++e) (*perm)[e] = e;
+        if (updated) {
+            // sigma = representative o relative transposition
+            uint16_t n16 = static_cast<uint16_t>(n);
+            vector<uint16_t> rep =
+                nth_permutation(n16, S.best_P_row * f[n - r + 1]);
+            vector<uint16_t> tr = nth_permutation(n16, S.best_T_row);
+            for (uint16_t e = 0; e < n; ++e) (*perm)[e] = rep[tr[e]];
+        }
+    }
+    return S.best;
+}
+
 inline size_t pop_first(bitset<N_H>& b) {
     size_t val = b._Find_first();
     b.reset(val);
@@ -84,9 +315,11 @@ class Node {
 
     Node(const Matroid* M);
     Node(const Node& other);
+    Node& operator=(const Node& other) = default;
 
     bool insert_plane(const size_t& p0);
     void remove_plane(const size_t& p0);
+    bool has_parallel() const;
     size_t select_plane();
 };
 
@@ -125,6 +358,9 @@ inline bool Node::insert_plane(const size_t& p) {
                     l0.reset(l);
                     l1.set(l);
                 } else if (l1[l]) {
+                    // All hyperplanes of the line are forced, i.e. the new
+                    // element lies on the line: a circuit of size < r
+                    if (paving_only) return false;
                     l1.reset(l);
                     l_stack.set(l);
                 }
@@ -176,6 +412,15 @@ inline void Node::remove_plane(const size_t& p) {
     }
 }
 
+// Whether the new element is parallel to an element (or a loop): all
+// hyperplanes containing that element are selected
+inline bool Node::has_parallel() const {
+    for (const bitset<N_H>& planes : M->element_hyperplanes) {
+        if ((planes & ~p_in).none()) return true;
+    }
+    return false;
+}
+
 inline string extend_matroid_LS(const Node& N, const string& base_colex_ext) {
     // Mark appropriate positions with '0'
     string colex_ext = base_colex_ext;
@@ -187,67 +432,203 @@ inline string extend_matroid_LS(const Node& N, const string& base_colex_ext) {
     return colex_ext;
 }
 
+// Set the positions of the zeros of the given hyperplanes in the colex string
+// of an extension of M (prefix included) to c: '0' to include them in the
+// linear subclass, '*' to undo that
+inline void set_plane_zeros(const Matroid& M, const bitset<N_H>& planes,
+                            char c, string& M_ext) {
+    for (size_t i = planes._Find_first(); i < N_H; i = planes._Find_next(i)) {
+        for (const uint16_t& pos : M.hyperplanes_to_zeros[i]) {
+            M_ext[bnml_nm1 + pos] = c;
+        }
+    }
+}
+
+// Flats of the extension of node.M by the linear subclass of the leaf node,
+// with new element n: the hyperplanes H of M not in the subclass, H + n for
+// those in it, and L + n for the hyperlines L of M in none of them. The
+// hyperlines L of M in at most one hyperplane of the subclass stay
+// hyperlines; the other hyperlines contain n. They are the intersections X
+// of two hyperplanes containing n whose hyperplanes through X partition the
+// elements outside X (as the points of the rank-2 contraction by X).
+inline Flats child_flats(const Node& node) {
+    const Matroid& M = *node.M;
+    Flats child;
+    vector<bitset<N>> planes_n;  // hyperplanes containing n
+    for (size_t i = 0; i < M.hyperplanes.size(); ++i) {
+        if (node.p_in[i])
+            planes_n.push_back(bitset<N>(M.hyperplanes[i]).set(M.n));
+        else
+            child.hyperplanes.push_back(M.hyperplanes[i]);
+    }
+    for (size_t l = 0; l < M.hyperlines.size(); ++l) {
+        if (node.l0[l])
+            planes_n.push_back(bitset<N>(M.hyperlines[l]).set(M.n));
+        if (node.l0[l] || node.l1[l])
+            child.hyperlines.push_back(M.hyperlines[l]);
+    }
+    unordered_set<bitset<N>> seen;
+    for (size_t a = 0; a < planes_n.size(); ++a) {
+        for (size_t b = a + 1; b < planes_n.size(); ++b) {
+            bitset<N> X = planes_n[a] & planes_n[b];
+            if (!seen.insert(X).second) continue;
+            size_t covered = 0;
+            for (const bitset<N>& H : planes_n)
+                if ((H & X) == X) covered += H.count() - X.count();
+            if (covered + X.count() == M.n + 1u)
+                child.hyperlines.push_back(X);
+        }
+    }
+    child.hyperplanes.insert(child.hyperplanes.end(), planes_n.begin(),
+                             planes_n.end());
+    return child;
+}
+
+// The extension of a partial linear subclass at a position, '?' if it depends
+// on a free hyperplane
+inline char partial_colex_at(const Node& N, const string& base_colex_ext,
+                             uint16_t pos) {
+    if (pos < bnml_nm1) return N.M->colex[pos];
+    pos -= bnml_nm1;
+    uint16_t i = N.M->zeros_to_hyperplanes[pos];
+    if (i != UINT16_MAX && N.p_in[i]) return '0';
+    if (i != UINT16_MAX && N.p_free[i]) return '?';
+    return base_colex_ext[pos];
+}
+
+inline uint16_t witness_fails(const Node& N, const string& base_colex_ext,
+                              const Witness& w) {
+    // Return the position of failure under w for all extensions by linear
+    // subclasses of the subtree of N, or bnml. Positions where the permuted
+    // string is '?' against '0', or '*' against '?', are equal or failing for
+    // all of them; any other uncertainty may prune.
+    for (uint16_t j = 0; j < w.end; ++j) {
+        uint16_t pos = w.P_row[w.T_row[j]];
+        char a = partial_colex_at(N, base_colex_ext, j);
+        char b = partial_colex_at(N, base_colex_ext, pos);
+        if (a == b && (a != '?' || pos == j)) continue;  // equal
+        if (a != '?' && b != '?') return a == '*' ? j : bnml;
+        if (a != '*' && b != '0') return bnml;
+    }
+    return bnml;
+}
+
+// M_ext is the colex string of the extension by the hyperplanes of node.p_in
+// (the seed followed by base_colex_ext with their zeros set), updated in
+// place along the search
 template <typename F>
-uint16_t dfs_search(Node& node, const string& base_colex_ext, F& on_extension) {
+uint16_t dfs_search(Node& node, const string& base_colex_ext, string& M_ext,
+                    F& on_extension) {
+    if (thread_stats) bump(thread_stats->nodes);
+
     // Find first free plane (ordered by first independent (r - 1)-subset)
     size_t p = node.p_free._Find_first();
 
     if (p == N_H) {
         // No more free planes - this is a complete linear subclass
-        string M_ext = node.M->colex + extend_matroid_LS(node, base_colex_ext);
-        uint16_t j_fail = is_canonical(M_ext.data(), node.M->r, node.M->n + 1);
+        uint16_t j_fail;
+        {
+            PerfScope check(PHASE_CHECK);
+            j_fail =
+                is_canonical_extension(M_ext.data(), node.M->r, node.M->n + 1);
+        }
+        if (thread_stats) {
+            bump(thread_stats->checks);
+            if (j_fail != bnml) bump(thread_stats->rejections);
+        }
         if (j_fail == bnml) {  // Canonical matroid
-            on_extension(Matroid(node.M->r, node.M->n + 1, M_ext));
+            PerfScope output(PHASE_OUTPUT);
+            Matroid M_child(node.M->r, node.M->n + 1, M_ext);
+            if (derive_child_flats) M_child.flats = child_flats(node);
+            on_extension(move(M_child));
         }
         return j_fail;
     }
 
+    // Cut the subtree if all its linear subclasses give non-canonical
+    // extensions
+    if (early_pruning && last_witness.P_row) {
+        uint16_t j_fail;
+        {
+            PerfScope check(PHASE_CHECK);
+            j_fail = witness_fails(node, base_colex_ext, last_witness);
+        }
+        if (thread_stats) {
+            bump(thread_stats->early_checks);
+            if (j_fail != bnml) bump(thread_stats->early_cuts);
+        }
+        if (j_fail != bnml) return j_fail;
+    }
+
     // Exclude plane p (continue with remaining planes)
     Node exclude_node(node);
     exclude_node.remove_plane(p);
     uint16_t exclusion_j_fail =
-        dfs_search(exclude_node, base_colex_ext, on_extension);
+        dfs_search(exclude_node, base_colex_ext, M_ext, on_extension);
 
     // If p adds zeros only after a current position of failure, we can skip
     // checking the inclusion branch (guaranteed non-canonical)
     if (exclusion_j_fail >= bnml_nm1 + node.M->hyperplanes_to_zeros[p][0]) {
         // Try including plane p
         Node include_node(node);
-        if (include_node.insert_plane(p)) {
-            dfs_search(include_node, base_colex_ext, on_extension);
+        if (include_node.insert_plane(p) &&
+            !(simple_only && include_node.has_parallel())) {
+            // The hyperplanes forced along with p are the undo trail
+            bitset<N_H> added = include_node.p_in & ~node.p_in;
+            set_plane_zeros(*node.M, added, '0', M_ext);
+            dfs_search(include_node, base_colex_ext, M_ext, on_extension);
+            set_plane_zeros(*node.M, added, '*', M_ext);
         }
     }
 
     return exclusion_j_fail;
 }
 
-template <typename F>
-void traverse_linear_subclasses(const Matroid& M, bool exclude_taboo,
-                                F& on_extension) {
+// Initialize M for the DFS over its linear subclasses, and return the colex
+// string of the new r-sets with all their zeros unset
+inline string init_search(const Matroid& M, bool exclude_taboo) {
     M.init_ind_sets_rm1();
     M.init_hyperplanes();
     M.init_hyperlines();
+    if (simple_only) M.init_element_hyperplanes();
+    if (exclude_taboo) M.init_taboo_hyperplanes();
 
-    // Create initial node
-    Node first_node(&M);
+    // Create base colex extension string of length C(n - 1, r - 1)
+    string base_colex_ext(bnml_nm1_rm1, '0');
+    for (bitset<N> I : M.ind_sets_rm1) {
+        I.set(M.n);
+        base_colex_ext[set_to_index[I.to_ulong()] - bnml_nm1] = '*';
+    }
+
+    init_prefix_branches(M, prefix_branches);
+    return base_colex_ext;
+}
 
+// The initial node of the DFS (after init_search)
+inline Node root_node(const Matroid& M, bool exclude_taboo) {
+    Node first_node(&M);
     if (exclude_taboo) {
-        M.init_taboo_hyperplanes();
         // Remove taboo hyperplanes
         for (bitset<N> T : M.taboo_hyperplanes) {
             first_node.remove_plane(M.hyperplanes_index[T]);
         }
     }
+    return first_node;
+}
 
-    // Create base colex extension string of length C(n - 1, r - 1)
-    string base_colex_ext(bnml_nm1_rm1, '0');
-    for (bitset<N> I : M.ind_sets_rm1) {
-        I.set(M.n);
-        base_colex_ext[set_to_index[I.to_ulong()] - bnml_nm1] = '*';
-    }
+template <typename F>
+void traverse_linear_subclasses(const Matroid& M, bool exclude_taboo,
+                                F& on_extension) {
+    PerfScope setup(PHASE_SETUP);
+    string base_colex_ext = init_search(M, exclude_taboo);
+    Node first_node = root_node(M, exclude_taboo);
+    if (simple_only && first_node.has_parallel()) return;
 
     // Start DFS from the initial node
-    dfs_search(first_node, base_colex_ext, on_extension);
+    PerfScope dfs(PHASE_DFS);
+    last_witness = Witness();
+    string M_ext = M.colex + base_colex_ext;
+    dfs_search(first_node, base_colex_ext, M_ext, on_extension);
 }
 
 template <typename F>
@@ -1,14 +1,22 @@
+#include <fcntl.h>
 #include <omp.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <queue>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 
+#include "async_io.h"
+#include "binary.h"
+#include "filename.h"
 #include "matroid.h"
+#include "minors.h"
 #include "sz.h"
 
 using namespace std;
@@ -16,176 +24,456 @@ namespace fs = filesystem;
 
 bool to_file = false;
 bool use_compression = false;
+bool use_binary = false;
+bool compress_thread_files = false;  // else plain text, which can be seeked
+size_t shard_index = 0;  // this process generates shard shard_index
+size_t num_shards = 1;   // out of num_shards
+chrono::seconds checkpoint_interval(60);  // between syncs of thread files
+
+// Output filename of a single run, e.g. output/r04n09 (or
+// output/r04n09-simple for the simple matroids only, output/r04n09-binary
+// without the minors of binary.txt)
+inline string base_filename(size_t r, size_t n) {
+    stringstream filename;
+    filename << level_filename(r, n);
+    if (simple_only) filename << "-simple";
+    if (paving_only) filename << "-paving";
+    if (!excluded_minors.empty()) filename << "-" << excluded_minors_name;
+    return filename.str();
+}
+
+// Output filename of a shard, e.g. output/r04n09-shard01of04
+inline string shard_filename(size_t r, size_t n, size_t shard) {
+    stringstream filename;
+    filename << base_filename(r, n) << "-shard" << setw(2) << setfill('0')
+             << shard << "of" << setw(2) << setfill('0') << num_shards;
+    return filename.str();
+}
+
+// Formats of colex files
+enum class Format { TEXT, SZ, BINARY };
+
+inline Format output_format() {
+    if (use_binary) return Format::BINARY;
+    return use_compression ? Format::SZ : Format::TEXT;
+}
+
+inline string extension(Format format) {
+    if (format == Format::SZ) return ".sz";
+    if (format == Format::BINARY) return ".bin";
+    return "";
+}
+
+// Output filename of this process (without extension)
+inline string output_basename(size_t r, size_t n) {
+    if (num_shards > 1) return shard_filename(r, n, shard_index);
+    return base_filename(r, n);
+}
 
 // Generate colex or .idx filenames based on r, n, and thread number
 inline string generate_filename(size_t r, size_t n, int thread_num,
                                 bool idx = false) {
     stringstream filename;
-    filename << "output/r" << setw(2) << setfill('0') << r << "n" << setw(2)
-             << setfill('0') << n << "-thread" << setw(2) << setfill('0')
+    filename << output_basename(r, n) << "-thread" << setw(2) << setfill('0')
              << thread_num;
     if (idx)
         filename << ".idx";
-    else if (use_compression)
+    else if (compress_thread_files)
         filename << ".sz";
     return filename.str();
 }
 
+// Seed matroids of the top level are distributed over the shards round-robin
+inline bool in_shard(size_t index) { return index % num_shards == shard_index; }
+
+// Make the written contents of a file durable
+inline void sync_file(const string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    ::close(fd);
+}
+
+// An AsyncFileBuf writing to filename, or nullptr if it cannot be created
+inline unique_ptr<streambuf> open_async_buf(const string& filename) {
+    auto buf = make_unique<AsyncFileBuf>();
+    if (!buf->open(filename)) return nullptr;
+    return buf;
+}
+
 struct ThreadState {
-    size_t current_index = SIZE_MAX;  // current index of seed matroid
-    size_t cnt = 0;                   // current number of extensions
-    ofstream idx_file;                // associated .idx file
+    size_t cnt = 0;  // number of extensions of the current seed matroid
+    vector<pair<size_t, size_t>> completed;  // (index, cnt) of completed seeds
+                                             // not yet in the .idx file
+    chrono::steady_clock::time_point last_checkpoint;
+    ofstream idx_file;  // associated .idx file
     unique_ptr<SZWriter> sz_writer;
-    ofstream colex_file;
+    unique_ptr<streambuf> colex_buf;
+    unique_ptr<ostream> colex_file;
     string filename;
     string idx_filename;
 
-    void open_files(size_t r, size_t n, int thread_num) {
+    bool open_files(size_t r, size_t n, int thread_num) {
         filename = generate_filename(r, n, thread_num);
         idx_filename = generate_filename(r, n, thread_num, true);
         idx_file.open(idx_filename);
-        if (use_compression) {
+        if (!idx_file) {
+            cerr << "Failed to open " << idx_filename << endl;
+            return false;
+        }
+        bool opened;
+        if (compress_thread_files) {
             sz_writer = make_unique<SZWriter>();
-            sz_writer->open(filename);
+            if (async_io)
+                opened = sz_writer->open(open_async_buf(filename));
+            else
+                opened = sz_writer->open(filename);
         } else {
-            colex_file.open(filename, ios::binary);
+            if (async_io) {
+                colex_buf = open_async_buf(filename);
+            } else {
+                auto buf = make_unique<filebuf>();
+                if (buf->open(filename, ios::out | ios::binary))
+                    colex_buf = move(buf);
+            }
+            opened = colex_buf != nullptr;
+            if (opened) colex_file = make_unique<ostream>(colex_buf.get());
+        }
+        if (!opened) {
+            cerr << "Failed to open " << filename << endl;
+            return false;
         }
+        last_checkpoint = chrono::steady_clock::now();
+        return true;
     }
 
     void write_colex(const string& line) {
-        if (use_compression)
+        cnt++;
+        if (compress_thread_files)
             sz_writer->write(line);
         else
-            colex_file << line << "\n";
+            *colex_file << line << "\n";
     }
 
-    void flush_idx() {
-        if (cnt > 0) idx_file << current_index << " " << cnt << "\n";
+    void complete_seed(size_t index) {
+        completed.push_back({index, cnt});
         cnt = 0;
+        if (chrono::steady_clock::now() - last_checkpoint >=
+            checkpoint_interval)
+            checkpoint();
+    }
+
+    // The colex lines are made durable before the .idx entries referring to
+    // them, so that the .idx file always describes a prefix of the colex file
+    void checkpoint() {
+        if (compress_thread_files)
+            sz_writer->flush();
+        else
+            colex_file->flush();
+        sync_file(filename);
+        for (auto [index, cnt] : completed)
+            idx_file << index << " " << cnt << "\n";
+        idx_file.flush();
+        sync_file(idx_filename);
+        completed.clear();
+        last_checkpoint = chrono::steady_clock::now();
     }
 
     void close_files() {
-        flush_idx();
+        checkpoint();
         idx_file.close();
-        if (use_compression)
+        if (compress_thread_files) {
             sz_writer->close();
-        else
-            colex_file.close();
+        } else {
+            colex_file->flush();
+            colex_file.reset();
+            colex_buf.reset();
+        }
     }
 };
 vector<ThreadState> thread_state;
+string output_filename;  // final output file (without extension)
+int resumed_files = 0;   // number of thread files kept from previous runs
+unordered_set<size_t> completed_seeds;  // seeds completed by previous runs
 
-// Open colex and .idx files (one pair per thread)
-void open_files(size_t r, size_t n, int threads) {
+// Open colex and .idx files (one pair per thread), numbered after the thread
+// files kept from previous runs. Returns false if a file cannot be created.
+bool open_files(size_t r, size_t n, int threads) {
     if (!fs::exists("output")) fs::create_directory("output");
+    output_filename = output_basename(r, n);
     thread_state.resize(threads);
-    for (int i = 0; i < threads; ++i) thread_state[i].open_files(r, n, i);
+    for (int i = 0; i < threads; ++i)
+        if (!thread_state[i].open_files(r, n, resumed_files + i)) return false;
+    return true;
+}
+
+// Copy the first cnt lines of a .sz file (at least cnt lines are decodable)
+inline void truncate_sz_file(const string& filename, size_t cnt) {
+    string tmp_filename = filename + ".tmp";
+    {
+        SZReader reader;
+        SZWriter writer;
+        writer.open(tmp_filename);
+        string line;
+        if (cnt > 0 && reader.open(filename)) {
+            for (size_t i = 0; i < cnt && reader.getline(line); ++i)
+                writer.write(line);
+        }
+    }
+    fs::rename(tmp_filename, filename);
+}
+
+// Keep the checkpointed part of the thread files of an interrupted run, i.e.
+// the longest prefix of .idx entries whose colex lines are complete. The
+// seeds of these entries are not processed again. Returns false if the thread
+// files are of the other format.
+inline bool resume_files(size_t r, size_t n) {
+    if (!fs::exists("output")) return true;
+    const size_t len = binomial(n, r);
+    for (;; ++resumed_files) {
+        string filename = generate_filename(r, n, resumed_files);
+        string idx_filename = generate_filename(r, n, resumed_files, true);
+        if (!fs::exists(idx_filename)) break;
+        // The thread files of --compressed-file are plain text with
+        // --longest-first or --numa, so the .idx file may have no colex file
+        // of this format
+        if (!fs::exists(filename)) {
+            cerr << "Cannot resume from " << idx_filename << " without "
+                 << filename << ": resume with the options of the run"
+                 << endl;
+            return false;
+        }
+
+        // Only newline-terminated .idx entries are complete
+        vector<pair<size_t, size_t>> entries;
+        ifstream idx_in(idx_filename);
+        string entry;
+        size_t total = 0;
+        while (getline(idx_in, entry) && !idx_in.eof()) {
+            size_t index, cnt;
+            if (!(stringstream(entry) >> index >> cnt)) break;
+            entries.push_back({index, cnt});
+            total += cnt;
+        }
+        idx_in.close();
+
+        // Number of complete colex lines
+        size_t lines = 0;
+        if (compress_thread_files) {
+            SZReader reader;
+            string line;
+            if (reader.open(filename))
+                while (lines < total && reader.getline(line)) lines++;
+        } else {
+            lines = min(total, fs::file_size(filename) / (len + 1));
+        }
+
+        size_t kept = 0;
+        ofstream idx_out(idx_filename);
+        for (auto [index, cnt] : entries) {
+            if (kept + cnt > lines) break;
+            kept += cnt;
+            idx_out << index << " " << cnt << "\n";
+            completed_seeds.insert(index);
+        }
+        idx_out.close();
+
+        if (compress_thread_files)
+            truncate_sz_file(filename, kept);
+        else
+            fs::resize_file(filename, kept * (len + 1));
+    }
+    if (resumed_files > 0)
+        cerr << "Resuming with " << completed_seeds.size()
+             << " completed seeds from " << resumed_files << " thread files"
+             << endl;
+    return true;
+}
+
+// Whether the top-level seed of the given index remains to be processed
+inline bool seed_pending(size_t index) {
+    return in_shard(index) && !completed_seeds.count(index);
 }
 
 // Output matroid either to file or to stdout
-inline void output_matroid(const Matroid& M, const size_t& index, int tid) {
+inline void output_matroid(const Matroid& M, int tid) {
     if (to_file) {
-        auto& ts = thread_state[tid];
-        if (index != ts.current_index) {
-            ts.flush_idx();
-            ts.current_index = index;
-        }
-        ts.cnt++;
-        ts.write_colex(M.colex);
+        thread_state[tid].write_colex(M.colex);
     } else {
 #pragma omp critical(io)
         cout << M.colex << endl;
     }
 }
 
-// Merge the colex files, using .idx files for sort order
-// The final output file coincides with the output of a single-threaded run
-inline void merge_files() {
-    size_t nfiles = thread_state.size();
+// Record that all extensions of a top-level seed have been output
+inline void complete_seed(size_t index, int tid) {
+    if (to_file) thread_state[tid].complete_seed(index);
+}
 
-    // Close all thread files
-    for (auto& ts : thread_state) ts.close_files();
+// Merge colex files of (r, n) matroids into out_filename (in the output
+// format), in the order of the seed indices of their .idx files. The seeds of
+// a compressed file must be in increasing order; plain text and binary files
+// are seeked instead. If out_idx_filename is nonempty, the .idx entries of
+// the merged file are written to it.
+inline void merge_indexed_files(const vector<string>& filenames,
+                                const vector<string>& idx_filenames,
+                                Format input_format, size_t r, size_t n,
+                                const string& out_filename,
+                                const string& out_idx_filename = "") {
+    size_t line_len = binomial(n, r);
+    size_t nfiles = filenames.size();
+
+    // Blocks of cnt lines generated from a seed, starting at a line of a file
+    struct Block {
+        size_t index;
+        size_t cnt;
+        size_t file_index;
+        size_t line;
+    };
+    vector<Block> blocks;
+    for (size_t i = 0; i < nfiles; ++i) {
+        ifstream idx_reader(idx_filenames[i]);
+        size_t index, cnt, line = 0;
+        while (idx_reader >> index >> cnt) {
+            blocks.push_back({index, cnt, i, line});
+            line += cnt;
+        }
+    }
+    sort(blocks.begin(), blocks.end(),
+         [](const Block& a, const Block& b) { return a.index < b.index; });
 
     // Open colex files for reading
     vector<unique_ptr<SZReader>> sz_readers;
+    vector<unique_ptr<BinaryReader>> bin_readers;
     vector<ifstream> colex_files;
-    if (use_compression) {
+    if (input_format == Format::SZ) {
         sz_readers.resize(nfiles);
         for (size_t i = 0; i < nfiles; ++i) {
             sz_readers[i] = make_unique<SZReader>();
-            sz_readers[i]->open(thread_state[i].filename);
+            sz_readers[i]->open(filenames[i]);
+        }
+    } else if (input_format == Format::BINARY) {
+        bin_readers.resize(nfiles);
+        for (size_t i = 0; i < nfiles; ++i) {
+            bin_readers[i] = make_unique<BinaryReader>();
+            bin_readers[i]->open(filenames[i]);
         }
     } else {
         colex_files.resize(nfiles);
         for (size_t i = 0; i < nfiles; ++i)
-            colex_files[i].open(thread_state[i].filename);
+            colex_files[i].open(filenames[i], ios::binary);
     }
-
-    // Open .idx files for reading
-    vector<ifstream> idx_readers(nfiles);
-    for (size_t i = 0; i < nfiles; ++i)
-        idx_readers[i].open(thread_state[i].idx_filename);
-
-    // Compute output filename from the first thread's filename
-    string output_filename = thread_state.front().filename.substr(
-        0, thread_state.front().filename.find('-'));
-    if (use_compression) output_filename += ".sz";
+    vector<size_t> next_line(nfiles, 0);
 
     unique_ptr<SZWriter> sz_out;
+    unique_ptr<BinaryWriter> bin_out;
     ofstream out;
+    ofstream idx_out;
 
-    // Open output file
-    if (use_compression) {
+    // Open output files
+    Format format = output_format();
+    if (format == Format::SZ) {
         sz_out = make_unique<SZWriter>();
-        sz_out->open(output_filename);
+        sz_out->open(out_filename);
+    } else if (format == Format::BINARY) {
+        vector<SeedRange> seeds;
+        uint64_t first = 0;
+        for (const Block& block : blocks) {
+            seeds.push_back({block.index, first, block.cnt});
+            first += block.cnt;
+        }
+        bin_out = make_unique<BinaryWriter>();
+        bin_out->open(out_filename, static_cast<uint16_t>(r),
+                      static_cast<uint16_t>(n),
+                      static_cast<uint32_t>(line_len), seeds);
     } else {
-        out.open(output_filename, ios::binary);
-    }
-
-    // Seed the priority queue with the first .idx entry from each file
-    priority_queue<tuple<size_t, size_t, size_t>,  // index, cnt, file_index
-                   vector<tuple<size_t, size_t, size_t>>, greater<>>
-        pq;
-    for (size_t i = 0; i < nfiles; ++i) {
-        size_t index, cnt;
-        if (idx_readers[i] >> index >> cnt) pq.push({index, cnt, i});
+        out.open(out_filename, ios::binary);
     }
+    if (!out_idx_filename.empty()) idx_out.open(out_idx_filename);
 
-    // Merge: for each .idx entry in index order, copy cnt colex lines
-    while (!pq.empty()) {
-        auto [index, cnt, file_index] = pq.top();
-        pq.pop();
-
-        for (size_t j = 0; j < cnt; ++j) {
-            string line;
-            if (use_compression) {
-                sz_readers[file_index]->getline(line);
+    // Merge: for each block in index order, copy its cnt colex lines
+    string line;
+    for (const Block& block : blocks) {
+        size_t i = block.file_index;
+        if (input_format == Format::TEXT && next_line[i] != block.line) {
+            colex_files[i].seekg(
+                static_cast<streamoff>(block.line * (line_len + 1)));
+        }
+        for (size_t j = 0; j < block.cnt; ++j) {
+            if (input_format == Format::SZ)
+                sz_readers[i]->getline(line);
+            else if (input_format == Format::BINARY)
+                line = bin_readers[i]->colex(block.line + j);
+            else
+                getline(colex_files[i], line);
+            if (format == Format::SZ)
                 sz_out->write(line);
-            } else {
-                getline(colex_files[file_index], line);
+            else if (format == Format::BINARY)
+                bin_out->write(line);
+            else
                 out << line << "\n";
-            }
         }
-
-        // Advance to the next .idx entry from the same thread file
-        size_t next_index, next_cnt;
-        if (idx_readers[file_index] >> next_index >> next_cnt)
-            pq.push({next_index, next_cnt, file_index});
+        next_line[i] = block.line + block.cnt;
+        if (idx_out.is_open())
+            idx_out << block.index << " " << block.cnt << "\n";
     }
 
     // Close all files
-    if (use_compression) {
-        for (auto& r : sz_readers) r->close();
+    for (auto& reader : sz_readers) reader->close();
+    for (auto& reader : bin_readers) reader->close();
+    for (auto& f : colex_files) f.close();
+    if (format == Format::SZ)
         sz_out->close();
-    } else {
-        for (auto& f : colex_files) f.close();
+    else if (format == Format::BINARY)
+        bin_out->close();
+    else
         out.close();
+    if (idx_out.is_open()) idx_out.close();
+}
+
+// Merge the thread files, using .idx files for sort order
+// The final output file coincides with the output of a single-threaded run.
+// A shard additionally keeps the .idx entries of its output.
+inline void merge_files(size_t r, size_t n) {
+    // Close all thread files
+    for (auto& ts : thread_state) ts.close_files();
+
+    // Thread files kept from previous runs come first
+    vector<string> filenames, idx_filenames;
+    for (int i = 0; i < resumed_files; ++i) {
+        filenames.push_back(generate_filename(r, n, i));
+        idx_filenames.push_back(generate_filename(r, n, i, true));
+    }
+    for (auto& ts : thread_state) {
+        filenames.push_back(ts.filename);
+        idx_filenames.push_back(ts.idx_filename);
     }
-    for (auto& f : idx_readers) f.close();
+    Format thread_format = compress_thread_files ? Format::SZ : Format::TEXT;
+    merge_indexed_files(filenames, idx_filenames, thread_format, r, n,
+                        output_filename + extension(output_format()),
+                        num_shards > 1 ? output_filename + ".idx" : "");
 
     // Delete thread-local files
-    for (auto& ts : thread_state) {
-        fs::remove(ts.filename);
-        fs::remove(ts.idx_filename);
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        fs::remove(filenames[i]);
+        fs::remove(idx_filenames[i]);
+    }
+}
+
+// Merge the outputs of all shards into the output of a single run
+inline bool merge_shards(size_t r, size_t n) {
+    vector<string> filenames, idx_filenames;
+    for (size_t i = 0; i < num_shards; ++i) {
+        string base = shard_filename(r, n, i);
+        filenames.push_back(base + extension(output_format()));
+        idx_filenames.push_back(base + ".idx");
+        if (!fs::exists(filenames.back()) ||
+            !fs::exists(idx_filenames.back())) {
+            cerr << "Missing output of shard " << i << ": " << base << endl;
+            return false;
+        }
     }
+    merge_indexed_files(filenames, idx_filenames, output_format(), r, n,
+                        base_filename(r, n) + extension(output_format()));
+    return true;
 }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Output filename of all canonical (r, n) matroids without extension, e.g.
+// output/r04n09, shared by the generator and the tools reading its output
+inline string level_filename(size_t r, size_t n) {
+    stringstream filename;
+    filename << "output/r" << setw(2) << setfill('0') << r << "n" << setw(2)
+             << setfill('0') << n;
+    return filename.str();
+}
@@ -0,0 +1,251 @@
+#include "libmatroid.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "binary.h"
+#include "combinatorics.h"
+#include "engine.h"
+#include "matroid.h"
+#include "minors.h"
+
+using namespace std;
+
+constexpr size_t BATCH_SIZE = 1 << 12;  // seeds extended per batch
+
+namespace {
+
+// Receives a matroid and its seed index; returning false stops the call
+using Emit = function<bool(const string&, uint64_t)>;
+
+unsigned options = 0;  // of ic_set_options
+
+// (r, n) of the matroids the tables extend, if set by ic_init
+int tables_r = -1;
+int tables_n = -1;
+
+bool valid_colex(const char* colex, size_t length) {
+    for (size_t i = 0; i < length; ++i)
+        if (colex[i] != '0' && colex[i] != '*') return false;
+    return true;
+}
+
+// Run body(i) for i in [begin, end) on the OpenMP threads. An exception must
+// not leave the parallel region (it would terminate the process), so the
+// first one is caught in the loop, the remaining iterations are skipped and
+// it is rethrown after the region.
+template <class F>
+void parallel_for(size_t begin, size_t end, int num_threads, const F& body) {
+    atomic<bool> failed{false};
+    exception_ptr error;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (size_t i = begin; i < end; ++i) {
+        if (failed.load(memory_order_relaxed)) continue;
+        try {
+            body(i);
+        } catch (...) {
+#pragma omp critical(libmatroid_error)
+            if (!error) error = current_exception();
+            failed.store(true, memory_order_relaxed);
+        }
+    }
+    if (error) rethrow_exception(error);
+}
+
+// Extends the top-level seeds of IC_generate() in batches and passes their
+// matroids to on_matroid from the calling thread, in the order of the seeds
+class LibraryDriver : public Driver {
+   private:
+    int num_threads;
+    const Emit& on_matroid;
+    vector<vector<string>> batch;  // matroids of the seeds of a batch
+    size_t batch_begin = 0;
+    bool batching = false;
+    bool stop = false;
+
+   public:
+    LibraryDriver(int num_threads, const Emit& on_matroid)
+        : num_threads(num_threads), on_matroid(on_matroid) {}
+
+    void extend(const vector<size_t>& order, bool top_level,
+                const ExtendSeed& extend_seed) override {
+        if (!top_level) {
+            parallel_for(0, order.size(), num_threads, [&](size_t k) {
+                extend_seed(order[k], omp_get_thread_num());
+            });
+            return;
+        }
+        // All seeds are pending, in index order
+        batching = true;
+        for (size_t begin = 0; begin < order.size() && !stop;
+             begin += BATCH_SIZE) {
+            size_t end = min(order.size(), begin + BATCH_SIZE);
+            batch.assign(end - begin, {});
+            batch_begin = begin;
+            parallel_for(begin, end, num_threads, [&](size_t i) {
+                extend_seed(i, omp_get_thread_num());
+            });
+            for (size_t i = begin; i < end && !stop; ++i) {
+                for (const string& colex : batch[i - begin]) {
+                    if (!on_matroid(colex, i)) {
+                        stop = true;
+                        break;
+                    }
+                }
+            }
+        }
+        batching = false;
+        batch.clear();
+    }
+
+    void emit(const Matroid& M, size_t index, int) override {
+        if (batching)
+            batch[index - batch_begin].push_back(M.colex);
+        else if (!stop && !on_matroid(M.colex, index))
+            stop = true;
+    }
+
+    bool stopped() override { return stop; }
+};
+
+// Pass all canonical (r, n) matroids to emit, in the order of IC. The options
+// of ic_set_options hold during the call only, so that ic_extend is not
+// restricted.
+int generate_matroids(uint16_t r, uint16_t n, int num_threads,
+                      const Emit& emit) {
+    if (r > n || n >= N) return IC_EINVAL;
+    tables_r = tables_n = -1;  // the tables are reinitialized
+    simple_only = options & IC_SIMPLE;
+    paving_only = options & IC_PAVING;
+    carry_flats = options & IC_CARRY_FLATS;
+    int status;
+    try {
+        LibraryDriver driver(max(num_threads, 1), emit);
+        IC_generate(r, n, driver);
+        status = driver.stopped() ? IC_STOPPED : IC_OK;
+    } catch (...) {
+        status = IC_ERROR;
+    }
+    simple_only = paving_only = carry_flats = false;
+    return status;
+}
+
+}  // namespace
+
+extern "C" {
+
+int ic_abi_version(void) { return IC_ABI_VERSION; }
+
+size_t ic_colex_length(uint16_t r, uint16_t n) {
+    return r > n ? 0 : binomial(n, r);
+}
+
+size_t ic_record_bytes(uint16_t r, uint16_t n) {
+    return (ic_colex_length(r, n) + 7) / 8;
+}
+
+int ic_init(uint16_t r, uint16_t n) {
+    if (r == 0 || r > n || n + 1 > N) return IC_EINVAL;
+    if (tables_r == r && tables_n == n) return IC_OK;
+    try {
+        allocate_combinatorics(static_cast<uint16_t>(n + 1), r);
+        initialize_combinatorics(static_cast<uint16_t>(n + 1), r);
+    } catch (...) {
+        return IC_ERROR;
+    }
+    tables_r = r;
+    tables_n = n;
+    return IC_OK;
+}
+
+int ic_set_options(unsigned flags) {
+    if (flags & ~unsigned(IC_SIMPLE | IC_PAVING | IC_CARRY_FLATS))
+        return IC_EINVAL;
+    options = flags;
+    return IC_OK;
+}
+
+int ic_exclude_minors(const char* filename) {
+    excluded_minors.clear();
+    excluded_minors_name.clear();
+    if (!filename) return IC_OK;
+    try {
+        if (read_excluded_minors(filename)) return IC_OK;
+    } catch (...) {
+        excluded_minors.clear();
+        return IC_ERROR;
+    }
+    excluded_minors.clear();
+    return IC_EINVAL;
+}
+
+void ic_free(void) {
+    free_combinatorics();
+    tables_r = tables_n = -1;
+}
+
+int ic_generate(uint16_t r, uint16_t n, int num_threads, ic_callback callback,
+                void* user) {
+    return generate_matroids(
+        r, n, num_threads, [&](const string& colex, uint64_t seed) {
+            return callback(colex.data(), colex.size(), seed, user) == 0;
+        });
+}
+
+int64_t ic_generate_packed(uint16_t r, uint16_t n, int num_threads,
+                           uint8_t* buffer, size_t capacity) {
+    size_t count = 0;
+    size_t record_bytes = ic_record_bytes(r, n);
+    int status = generate_matroids(
+        r, n, num_threads, [&](const string& colex, uint64_t) {
+            if (count < capacity)
+                pack_colex(colex.data(), colex.size(),
+                           buffer + count * record_bytes);
+            count++;
+            return true;
+        });
+    return status == IC_OK ? static_cast<int64_t>(count) : status;
+}
+
+int ic_extend(uint16_t r, uint16_t n, const char* seeds, size_t num_seeds,
+              int num_threads, ic_callback callback, void* user) {
+    int status = ic_init(r, n);
+    if (status != IC_OK) return status;
+    size_t length = binomial(n, r);
+    if (!valid_colex(seeds, num_seeds * length)) return IC_EINVAL;
+
+    try {
+        for (size_t begin = 0; begin < num_seeds; begin += BATCH_SIZE) {
+            size_t end = min(num_seeds, begin + BATCH_SIZE);
+            vector<vector<string>> extensions(end - begin);
+            parallel_for(begin, end, max(num_threads, 1), [&](size_t i) {
+                string colex(seeds + i * length, length);
+                Matroid M(r, n, colex);
+                M.canonical_extensions([&](const Matroid& M_ext) {
+                    extensions[i - begin].push_back(M_ext.colex);
+                });
+                // The extension by a coloop
+                extensions[i - begin].push_back(
+                    string(binomial(n, r + 1), '0') + colex);
+            });
+            for (size_t i = begin; i < end; ++i) {
+                for (const string& colex : extensions[i - begin]) {
+                    if (callback(colex.data(), colex.size(), i, user) != 0)
+                        return IC_STOPPED;
+                }
+            }
+        }
+    } catch (...) {
+        return IC_ERROR;
+    }
+    return IC_OK;
+}
+
+}  // extern "C"
@@ -0,0 +1,80 @@
+#pragma once
+
+// C interface of build/libmatroid.so, the generation engine of IC without
+// output files: generate all canonical (r, n) matroids, or extend seeds.
+// Colex strings consist of '0' (non-basis) and '*' (basis) and have length
+// C(n, r). The engine keeps global tables, so calls must not overlap (one
+// generation at a time per process); OpenMP threads are used within a call.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IC_ABI_VERSION 1
+
+#define IC_API __attribute__((visibility("default")))
+
+#define IC_OK 0
+#define IC_EINVAL (-1)   // invalid (r, n) or colex string
+#define IC_STOPPED (-2)  // stopped by the callback
+#define IC_ERROR (-3)    // internal error, e.g. out of memory
+
+// Options of ic_set_options, as the flags of IC
+#define IC_SIMPLE 1       // --simple
+#define IC_PAVING 2       // --paving
+#define IC_CARRY_FLATS 4  // --carry-flats
+
+// Receives a colex string (not null-terminated) of the given length, and the
+// index of the seed it was generated from. Returning nonzero stops the call.
+typedef int (*ic_callback)(const char* colex, size_t length, uint64_t seed,
+                           void* user);
+
+IC_API int ic_abi_version(void);
+
+// C(n, r), the length of the colex strings of (r, n) matroids
+IC_API size_t ic_colex_length(uint16_t r, uint16_t n);
+
+// Bytes of a packed record of an (r, n) matroid: bit j (byte j / 8, bit j % 8
+// from the least significant) is 1 iff position j is '*', as in --binary
+IC_API size_t ic_record_bytes(uint16_t r, uint16_t n);
+
+// Initialize the tables for extending (r, n) matroids (done by ic_extend if
+// needed), or free them
+IC_API int ic_init(uint16_t r, uint16_t n);
+IC_API void ic_free(void);
+
+// Set the options (a combination of IC_SIMPLE, IC_PAVING and IC_CARRY_FLATS,
+// none by default) of the following calls of ic_generate and
+// ic_generate_packed
+IC_API int ic_set_options(unsigned options);
+
+// Restrict the following calls of ic_generate and ic_generate_packed to the
+// matroids without the minors listed in the file, as --exclude-minors of IC,
+// or lift the restriction if filename is NULL
+IC_API int ic_exclude_minors(const char* filename);
+
+// Pass all canonical (r, n) matroids to the callback, from the calling thread
+// and in the order of the output of IC (with the seed indices of its .idx
+// files)
+IC_API int ic_generate(uint16_t r, uint16_t n, int num_threads,
+                       ic_callback callback, void* user);
+
+// Write the packed records of the first `capacity` canonical (r, n) matroids
+// to buffer (capacity * ic_record_bytes(r, n) bytes). Returns the total
+// number of matroids, or a negative error code.
+IC_API int64_t ic_generate_packed(uint16_t r, uint16_t n, int num_threads,
+                                  uint8_t* buffer, size_t capacity);
+
+// Pass the single-element extensions (up to isomorphism, as by IC-extend) of
+// num_seeds (r, n) matroids, given as consecutive colex strings, to the
+// callback with the index of their seed, in the order of the seeds
+IC_API int ic_extend(uint16_t r, uint16_t n, const char* seeds,
+                     size_t num_seeds, int num_threads, ic_callback callback,
+                     void* user);
+
+#ifdef __cplusplus
+}
+#endif
@@ -71,9 +71,12 @@ void Matroid::init_hyperplanes() const {
     // Hyperplanes are ordered by the colex order of their colex-smallest
     // independent (r - 1)-set. This ensures the lexicographic order of the
     // final output.
-    unordered_set<bitset<N>> H_unordered;
-    for (const bitset<N>& I : ind_sets_rm1) {
-        H_unordered.insert(closure(I));
+    unordered_set<bitset<N>> H_unordered(flats.hyperplanes.begin(),
+                                         flats.hyperplanes.end());
+    if (flats.hyperplanes.empty()) {
+        for (const bitset<N>& I : ind_sets_rm1) {
+            H_unordered.insert(closure(I));
+        }
     }
     hyperplanes.reserve(H_unordered.size());
     for (const auto& I : ind_sets_rm1) {
@@ -92,12 +95,14 @@ void Matroid::init_hyperplanes() const {
         hyperplanes_index[hyperplanes[i]] = i;
     }
     hyperplanes_to_zeros.resize(hyperplanes.size());
+    zeros_to_hyperplanes.assign(bnml_nm1_rm1, UINT16_MAX);
     for (bitset<N> I : ind_sets_rm1) {
         for (uint16_t i = 0; i < hyperplanes.size(); ++i) {
             if ((I & hyperplanes[i]) == I) {
                 I.set(n);
-                hyperplanes_to_zeros[i].push_back(set_to_index[I.to_ulong()] -
-                                                  bnml_nm1);
+                uint16_t pos = set_to_index[I.to_ulong()] - bnml_nm1;
+                hyperplanes_to_zeros[i].push_back(pos);
+                zeros_to_hyperplanes[pos] = i;
             }
         }
     }
@@ -117,34 +122,44 @@ void Matroid::init_taboo_hyperplanes() const {
         }
     }
 
-    // Prop. 2
+    // Prop. 2, with the ranks from the colex string and the hyperplanes
     for (const bitset<N> S : combinations<N>(n - 1, r - 1)) {
         bitset<N> SS = S;
-        SS.set(n - 1);                // add n - 2
-        if (rank(SS) < SS.count()) {  // dependent
-            if (rank(S) < S.count()) {
+        SS.set(n - 1);                                     // add n - 2
+        if (colex[set_to_index[SS.to_ulong()]] == '0') {  // dependent
+            if (!ind_sets_rm1.count(S)) {
                 // forced '0' agreement
                 continue;
             }
             break;
         }
-        // forced '*' agreement
-        taboo_hyperplanes.insert(closure(S));
+        // forced '*' agreement: the closure of S is its hyperplane
+        for (const bitset<N>& H : hyperplanes) {
+            if ((S & H) == S) {
+                taboo_hyperplanes.insert(H);
+                break;
+            }
+        }
     }
 }
 
 // Flats of rank r - 2
 void Matroid::init_hyperlines() const {
-    unordered_set<bitset<N>> res_set;
-    for (const bitset<N>& H : hyperplanes) {
-        for (const bitset<N>& T : hyperplanes) {
-            bitset<N> intersection = H & T;
-            if (intersection.count() + 2 >= r && rank(intersection) + 2 == r) {
-                res_set.insert(intersection);
+    if (!flats.hyperplanes.empty()) {
+        hyperlines = flats.hyperlines;
+    } else {
+        unordered_set<bitset<N>> res_set;
+        for (const bitset<N>& H : hyperplanes) {
+            for (const bitset<N>& T : hyperplanes) {
+                bitset<N> intersection = H & T;
+                if (intersection.count() + 2 >= r &&
+                    rank(intersection) + 2 == r) {
+                    res_set.insert(intersection);
+                }
             }
         }
+        hyperlines.assign(res_set.begin(), res_set.end());
     }
-    hyperlines.assign(res_set.begin(), res_set.end());
     planes_to_lines.resize(hyperplanes.size());
     lines_to_planes.resize(hyperlines.size());
     for (const bitset<N>& H : hyperplanes) {
@@ -158,3 +173,13 @@ void Matroid::init_hyperlines() const {
         }
     }
 }
+
+// Hyperplanes containing each element
+void Matroid::init_element_hyperplanes() const {
+    element_hyperplanes.assign(n, bitset<N_H>());
+    for (size_t i = 0; i < hyperplanes.size(); ++i) {
+        for (uint16_t e = 0; e < n; ++e) {
+            if (hyperplanes[i][e]) element_hyperplanes[e].set(i);
+        }
+    }
+}
@@ -12,6 +12,14 @@
 
 using namespace std;
 
+// Hyperplanes and hyperlines of a matroid, as derived from its parent in the
+// recursion of IC(). Empty if not derived (a matroid of rank r > 0 has a
+// hyperplane).
+struct Flats {
+    vector<bitset<N>> hyperplanes;
+    vector<bitset<N>> hyperlines;
+};
+
 class Matroid {
    private:
     mutable unordered_map<bitset<N>, uint16_t> rank_cache;
@@ -29,6 +37,9 @@ class Matroid {
     mutable vector<vector<uint16_t>> lines_to_planes;
     mutable unordered_map<bitset<N>, uint16_t> hyperplanes_index;
     mutable vector<vector<uint16_t>> hyperplanes_to_zeros;
+    mutable vector<uint16_t> zeros_to_hyperplanes;
+    mutable vector<bitset<N_H>> element_hyperplanes;
+    Flats flats;  // replace the computation of the flats, if derived
 
     Matroid(const uint16_t& r, const uint16_t& n, const string& colex)
         : r(r), n(n), colex(colex) {}
@@ -39,6 +50,7 @@ class Matroid {
     void init_hyperplanes() const;
     void init_taboo_hyperplanes() const;
     void init_hyperlines() const;
+    void init_element_hyperplanes() const;
 
     Matroid coloop_extension() const {
         string colex(bnml, '0');
@@ -46,7 +58,21 @@ class Matroid {
         for (uint16_t i = 0; i < bnml_nm1_rm1; ++i) {
             colex[bnml_nm1 + i] = this->colex[i];
         }
-        return Matroid(this->r + 1, this->n + 1, colex);
+        Matroid M_ext(this->r + 1, this->n + 1, colex);
+        if (!flats.hyperplanes.empty()) {
+            // Hyperplanes H + n and the ground set, hyperlines L + n and H
+            bitset<N> ground;
+            for (uint16_t e = 0; e < n; ++e) ground.set(e);
+            for (bitset<N> H : flats.hyperplanes)
+                M_ext.flats.hyperplanes.push_back(H.set(n));
+            M_ext.flats.hyperplanes.push_back(ground);
+            for (bitset<N> L : flats.hyperlines)
+                M_ext.flats.hyperlines.push_back(L.set(n));
+            M_ext.flats.hyperlines.insert(M_ext.flats.hyperlines.end(),
+                                          flats.hyperplanes.begin(),
+                                          flats.hyperplanes.end());
+        }
+        return M_ext;
     }
 
     template <typename F>
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "combinatorics.h"
+#include "properties.h"
+
+using namespace std;
+
+// Bases of a minor of at most 9 elements, one bit per r-set in colex order
+constexpr size_t MINOR_BITS = 128;
+using MinorBases = bitset<MINOR_BITS>;
+
+// An excluded minor with the bases of all its relabellings
+struct ExcludedMinor {
+    uint16_t r;
+    uint16_t n;
+    unordered_set<MinorBases> relabellings;
+};
+
+// Restriction of the generated matroids to the class without these minors,
+// which is closed under deletion like --simple and --paving
+inline vector<ExcludedMinor> excluded_minors;
+inline string excluded_minors_name;  // suffix of the output files
+
+// The r-sets of [n] in colex order, cached per thread
+inline const vector<bitset<N>>& colex_sets(uint16_t n, uint16_t r) {
+    static thread_local map<pair<uint16_t, uint16_t>, vector<bitset<N>>> sets;
+    auto it = sets.find({n, r});
+    if (it == sets.end())
+        it = sets.emplace(make_pair(n, r), combinations<N>(n, r)).first;
+    return it->second;
+}
+
+inline ExcludedMinor excluded_minor(uint16_t r, uint16_t n,
+                                    const string& colex) {
+    ExcludedMinor minor{r, n, {}};
+    const vector<bitset<N>> sets = combinations<N>(n, r);
+    unordered_map<bitset<N>, size_t> index;
+    for (size_t i = 0; i < sets.size(); ++i) index[sets[i]] = i;
+    vector<uint16_t> perm(n);
+    iota(perm.begin(), perm.end(), 0);
+    do {
+        MinorBases bases;
+        for (size_t i = 0; i < sets.size(); ++i) {
+            if (colex[i] != '*') continue;
+            bitset<N> image;
+            for (uint16_t e = 0; e < n; ++e)
+                if (sets[i][e]) image.set(perm[e]);
+            bases.set(index[image]);
+        }
+        minor.relabellings.insert(bases);
+    } while (next_permutation(perm.begin(), perm.end()));
+    return minor;
+}
+
+// Read the excluded minors from lines "<r> <n> <colex>", as printed by
+// scripts/excluded-minors.py; other lines (not starting with a digit) are
+// skipped
+inline bool read_excluded_minors(const string& filename) {
+    ifstream in(filename);
+    if (!in) {
+        cerr << "Failed to open " << filename << endl;
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || !isdigit(static_cast<unsigned char>(line[0])))
+            continue;
+        istringstream fields(line);
+        size_t r, n;
+        string colex;
+        if (!(fields >> r >> n >> colex) || r > n || n > 9 ||
+            colex.size() != binomial(n, r) ||
+            colex.find_first_not_of("*0") != string::npos) {
+            cerr << "Invalid excluded minor (at most 9 elements): " << line
+                 << endl;
+            return false;
+        }
+        excluded_minors.push_back(excluded_minor(
+            static_cast<uint16_t>(r), static_cast<uint16_t>(n), colex));
+    }
+    excluded_minors_name = filename.substr(filename.find_last_of('/') + 1);
+    excluded_minors_name =
+        excluded_minors_name.substr(0, excluded_minors_name.find('.'));
+    return true;
+}
+
+// Whether the (r, n) matroid given by colex has an excluded minor M / C \ D,
+// with C independent. Only the minors on which element e is contracted or
+// kept are tested (all of them if e >= n): the others are minors of M \ e.
+inline bool has_excluded_minor(uint16_t r, uint16_t n, const string& colex,
+                               uint16_t e) {
+    static thread_local vector<uint8_t> rank;
+    if (excluded_minors.empty()) return false;
+    rank_table(n, colex, colex_sets(n, r), rank);
+    for (const ExcludedMinor& minor : excluded_minors) {
+        // The minor needs at most the nullity of M (also for T_sets)
+        if (minor.r > r || minor.n - minor.r > n - r) continue;
+        const vector<bitset<N>>& minor_sets = colex_sets(minor.n, minor.r);
+        uint16_t c = static_cast<uint16_t>(r - minor.r);
+        const vector<bitset<N>>& T_sets =
+            colex_sets(static_cast<uint16_t>(n - c), minor.n);
+        for (const bitset<N>& C_set : colex_sets(n, c)) {
+            uint32_t C = static_cast<uint32_t>(C_set.to_ulong());
+            if (rank[C] != c) continue;
+            for (const bitset<N>& T_set : T_sets) {
+                // T_set on the elements outside C, in increasing order
+                uint32_t T = 0;
+                uint16_t elements[N];
+                for (uint16_t x = 0, k = 0, m = 0; x < n; ++x) {
+                    if (C >> x & 1) continue;
+                    if (T_set[k++]) {
+                        T |= uint32_t(1) << x;
+                        elements[m++] = x;
+                    }
+                }
+                if ((e < n && !((C | T) >> e & 1)) || rank[C | T] != r)
+                    continue;
+                // Bases of (M / C) | T: B with B + C a basis of M
+                MinorBases bases;
+                for (size_t i = 0; i < minor_sets.size(); ++i) {
+                    uint32_t B = C;
+                    for (uint16_t k = 0; k < minor.n; ++k)
+                        if (minor_sets[i][k]) B |= uint32_t(1) << elements[k];
+                    if (rank[B] == r) bases.set(i);
+                }
+                if (minor.relabellings.count(bases)) return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <omp.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+
+using namespace std;
+
+inline bool numa_aware = false;  // per-node tables, pinning and seed queues
+inline bool huge_pages = false;  // back the replicas by huge pages
+
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+constexpr size_t SEED_BLOCK = 64;  // consecutive seeds dealt to a node queue
+
+// CPUs of each NUMA node from sysfs, or one node of all CPUs
+inline vector<vector<int>> numa_node_cpus() {
+    vector<vector<int>> nodes;
+    for (int node = 0;; ++node) {
+        ifstream in("/sys/devices/system/node/node" + to_string(node) +
+                    "/cpulist");
+        if (!in) break;
+        vector<int> cpus;
+        string range;
+        while (getline(in, range, ',')) {
+            int first, last;
+            char dash;
+            istringstream r(range);
+            if (!(r >> first)) continue;
+            last = r >> dash >> last ? last : first;
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        if (!cpus.empty()) nodes.push_back(cpus);
+    }
+    if (nodes.empty()) {
+        nodes.emplace_back();
+        for (long cpu = 0; cpu < sysconf(_SC_NPROCESSORS_ONLN); ++cpu)
+            nodes.back().push_back(static_cast<int>(cpu));
+    }
+    return nodes;
+}
+
+// Memory mapped for a replica, on huge pages if requested
+class Mapping {
+   private:
+    void* data = MAP_FAILED;
+    size_t size = 0;
+
+   public:
+    bool huge = false;  // explicit huge pages
+
+    Mapping(size_t bytes) {
+        size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        if (huge_pages) {
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            huge = data != MAP_FAILED;
+        }
+        if (data == MAP_FAILED) {
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            // Else transparent huge pages
+            if (huge_pages && data != MAP_FAILED)
+                madvise(data, size, MADV_HUGEPAGE);
+        }
+        if (data == MAP_FAILED) throw bad_alloc();
+    }
+
+    ~Mapping() { munmap(data, size); }
+
+    template <typename V>
+    V* as() const {
+        return static_cast<V*>(data);
+    }
+};
+
+// Replicas of the tables of the current level on each NUMA node, the node of
+// each thread, and per-node queues of seeds. Threads are assigned to nodes in
+// contiguous blocks, in proportion to their CPUs.
+class NumaTables {
+   private:
+    struct Replica {
+        unique_ptr<Mapping> P, T, perm_reps;
+        TableReplica tables;
+    };
+
+    vector<vector<int>> cpus;
+    vector<size_t> thread_node;
+    vector<Replica> replicas;
+
+    // Seeds dealt to the nodes and the next position of each queue
+    vector<vector<size_t>> queues;
+    unique_ptr<atomic<size_t>[]> next;
+
+    // Share of the pages of the tables read by each thread that are on its
+    // node, by the kernel's placement of the pages
+    double local_share(bool replicated) const {
+        size_t local = 0, total = 0;
+        long page_size = sysconf(_SC_PAGESIZE);
+        for (size_t tid = 0; tid < thread_node.size(); ++tid) {
+            size_t node = thread_node[tid];
+            const TableReplica& t = replicated ? replicas[node].tables
+                                               : TableReplica{P, T,
+                                                  r_set_to_perm_reps.data()};
+            for (auto [ptr, bytes] : table_ranges(t)) {
+                uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) /
+                                  static_cast<uintptr_t>(page_size) *
+                                  static_cast<uintptr_t>(page_size);
+                vector<void*> pages;
+                for (uintptr_t a = begin;
+                     a < reinterpret_cast<uintptr_t>(ptr) + bytes;
+                     a += static_cast<uintptr_t>(page_size))
+                    pages.push_back(reinterpret_cast<void*>(a));
+                vector<int> status(pages.size(), -1);
+                // Query only (no target nodes)
+                if (syscall(SYS_move_pages, 0, pages.size(), pages.data(),
+                            nullptr, status.data(), 0) != 0)
+                    return -1;
+                for (int s : status) {
+                    if (s < 0) continue;  // not present
+                    total++;
+                    local += static_cast<size_t>(s) == node;
+                }
+            }
+        }
+        return total > 0 ? static_cast<double>(local) /
+                               static_cast<double>(total)
+                         : -1;
+    }
+
+    static vector<pair<const void*, size_t>> table_ranges(
+        const TableReplica& t) {
+        return {{t.P, P_size * sizeof(uint16_t)},
+                {t.T, T_size * sizeof(uint16_t)},
+                {t.r_set_to_perm_reps, perm_reps_size * sizeof(size_t)}};
+    }
+
+   public:
+    // Entries of the tables of the current level
+    static inline size_t P_size = 0, T_size = 0, perm_reps_size = 0;
+
+    NumaTables(int num_threads) : cpus(numa_node_cpus()) {
+        size_t total = 0;
+        for (const auto& c : cpus) total += c.size();
+        for (size_t node = 0, seen = 0; node < cpus.size(); ++node) {
+            seen += cpus[node].size();
+            while (thread_node.size() <
+                   (seen * static_cast<size_t>(num_threads) + total - 1) /
+                       total)
+                thread_node.push_back(node);
+        }
+        replicas.resize(cpus.size());
+    }
+
+    size_t nodes() const { return cpus.size(); }
+
+    size_t node_of(int tid) const {
+        return thread_node[static_cast<size_t>(tid)];
+    }
+
+    // Pin the calling thread to the CPUs of its node and read the tables of
+    // that node
+    void attach(int tid) {
+        const Replica& replica = replicas[node_of(tid)];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus[node_of(tid)]) CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+        thread_tables = replica.tables;
+    }
+
+    static void detach() { thread_tables = TableReplica(); }
+
+    // Copy the tables of the (r, n) level (after initialize_combinatorics) to
+    // each node, by a thread of that node so that its pages are placed there
+    void replicate(uint16_t n, uint16_t r) {
+        P_size = static_cast<size_t>(binomial(n, r)) * factorial(r) *
+                 binomial(n, r);
+        T_size = factorial(n - r) * static_cast<size_t>(binomial(n, r));
+        perm_reps_size = static_cast<size_t>(binomial(n, r)) * factorial(r);
+#pragma omp parallel num_threads(static_cast<int>(thread_node.size()))
+        {
+            int tid = omp_get_thread_num();
+            size_t node = node_of(tid);
+            if (tid == 0 || node_of(tid - 1) != node) {
+                attach(tid);
+                Replica& replica = replicas[node];
+                replica.P = make_unique<Mapping>(P_size * sizeof(uint16_t));
+                replica.T = make_unique<Mapping>(T_size * sizeof(uint16_t));
+                replica.perm_reps =
+                    make_unique<Mapping>(perm_reps_size * sizeof(size_t));
+                memcpy(replica.P->as<uint16_t>(), P,
+                       P_size * sizeof(uint16_t));
+                memcpy(replica.T->as<uint16_t>(), T,
+                       T_size * sizeof(uint16_t));
+                memcpy(replica.perm_reps->as<size_t>(),
+                       r_set_to_perm_reps.data(),
+                       perm_reps_size * sizeof(size_t));
+                replica.tables = {replica.P->as<uint16_t>(),
+                                  replica.T->as<uint16_t>(),
+                                  replica.perm_reps->as<size_t>()};
+                detach();
+            }
+        }
+    }
+
+    // Deal the seeds to the node queues in blocks of consecutive seeds
+    void deal(const vector<size_t>& order) {
+        queues.assign(nodes(), {});
+        for (size_t k = 0; k < order.size(); ++k)
+            queues[k / SEED_BLOCK % nodes()].push_back(order[k]);
+        next = make_unique<atomic<size_t>[]>(nodes());
+    }
+
+    // The next seed for a thread: of its node's queue, else of another node
+    bool pop(int tid, size_t& seed) {
+        for (size_t k = 0; k < nodes(); ++k) {
+            size_t node = (node_of(tid) + k) % nodes();
+            size_t pos = next[node].fetch_add(1);
+            if (pos < queues[node].size()) {
+                seed = queues[node][pos];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void report() const {
+        auto percent = [](double share) {
+            ostringstream s;
+            if (share < 0)
+                s << "unknown";
+            else
+                s << fixed << setprecision(1) << 100 * share << "%";
+            return s.str();
+        };
+        cerr << "NUMA: " << nodes() << " node(s), " << thread_node.size()
+             << " thread(s), ";
+        if (huge_pages)
+            cerr << (replicas[0].P && replicas[0].P->huge ? "explicit"
+                                                          : "transparent")
+                 << " huge pages, ";
+        cerr << "local table pages " << percent(local_share(true))
+             << " (shared tables " << percent(local_share(false)) << ")"
+             << endl;
+    }
+};
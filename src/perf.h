@@ -0,0 +1,212 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Phases of the extension of a seed, attributed the counters while active
+enum Phase { PHASE_OTHER, PHASE_SETUP, PHASE_DFS, PHASE_CHECK, PHASE_OUTPUT };
+constexpr size_t PHASES = 5;
+constexpr const char* PHASE_NAMES[PHASES] = {"other", "setup", "dfs",
+                                             "check", "output"};
+
+// Events of a group read at once: the task clock (a software event) leads,
+// so that the hardware events are optional
+struct PerfEvent {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+constexpr size_t PERF_EVENTS = 5;
+constexpr PerfEvent PERF_EVENT_LIST[PERF_EVENTS] = {
+    {"task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+inline int perf_event_open(const PerfEvent& e, int group_fd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = e.type;
+    attr.config = e.config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = group_fd < 0;
+    // User space only, as allowed by perf_event_paranoid <= 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// Counters of the calling thread, accumulated per phase. Each phase switch
+// reads the group (one system call).
+class PerfCounters {
+   private:
+    int leader = -1;
+    vector<int> fds;
+    vector<size_t> events;  // indices into PERF_EVENT_LIST, in group order
+    array<uint64_t, PERF_EVENTS> last{};
+    Phase phase = PHASE_OTHER;
+
+    void read_group(array<uint64_t, PERF_EVENTS>& values) const {
+        uint64_t buf[1 + PERF_EVENTS] = {};
+        if (::read(leader, buf, sizeof(buf)) <= 0) return;
+        for (size_t k = 0; k < events.size() && k < buf[0]; ++k)
+            values[events[k]] = buf[1 + k];
+    }
+
+   public:
+    array<array<uint64_t, PERF_EVENTS>, PHASES> totals{};
+    string error;  // why the counters are not available
+
+    // Open the counters of the calling thread
+    bool open() {
+        for (size_t k = 0; k < PERF_EVENTS; ++k) {
+            int fd = perf_event_open(PERF_EVENT_LIST[k], leader);
+            if (fd < 0) {
+                if (k == 0) {
+                    error = strerror(errno);
+                    return false;
+                }
+                continue;
+            }
+            if (k == 0) leader = fd;
+            fds.push_back(fd);
+            events.push_back(k);
+        }
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        read_group(last);
+        return true;
+    }
+
+    bool has(size_t event) const {
+        for (size_t k : events)
+            if (k == event) return true;
+        return false;
+    }
+
+    // Attribute the counts since the last switch to the current phase, and
+    // make p current. Returns the previous phase.
+    Phase enter(Phase p) {
+        array<uint64_t, PERF_EVENTS> now = last;
+        read_group(now);
+        for (size_t k = 0; k < PERF_EVENTS; ++k)
+            totals[phase][k] += now[k] - last[k];
+        last = now;
+        Phase previous = phase;
+        phase = p;
+        return previous;
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds) ::close(fd);
+    }
+};
+
+// Counters of the current thread, or nullptr if not collected
+inline thread_local PerfCounters* thread_perf = nullptr;
+
+// Attributes the counters to a phase during its lifetime
+class PerfScope {
+   private:
+    Phase previous = PHASE_OTHER;
+
+   public:
+    explicit PerfScope(Phase p) {
+        if (thread_perf) previous = thread_perf->enter(p);
+    }
+    ~PerfScope() {
+        if (thread_perf) thread_perf->enter(previous);
+    }
+};
+
+// The counters of all threads, opened by each thread when it first attaches
+class PerfReport {
+   private:
+    vector<PerfCounters> threads;
+    vector<bool> opened;
+
+   public:
+    explicit PerfReport(int num_threads)
+        : threads(static_cast<size_t>(num_threads)),
+          opened(static_cast<size_t>(num_threads)) {}
+
+    void attach(int tid) {
+        size_t t = static_cast<size_t>(tid);
+        if (!opened[t]) {
+            opened[t] = true;
+            if (!threads[t].open()) return;
+        }
+        if (threads[t].error.empty()) thread_perf = &threads[t];
+    }
+
+    static void detach() {
+        if (thread_perf) thread_perf->enter(PHASE_OTHER);
+        thread_perf = nullptr;
+    }
+
+    // Per-phase sums over the threads, with the share of the task clock
+    void print(ostream& out) const {
+        array<array<uint64_t, PERF_EVENTS>, PHASES> sum{};
+        array<bool, PERF_EVENTS> available{};
+        string error;
+        for (size_t t = 0; t < threads.size(); ++t) {
+            if (!opened[t]) continue;
+            if (!threads[t].error.empty()) error = threads[t].error;
+            for (size_t k = 0; k < PERF_EVENTS; ++k)
+                available[k] = available[k] || threads[t].has(k);
+            for (size_t p = 0; p < PHASES; ++p)
+                for (size_t k = 0; k < PERF_EVENTS; ++k)
+                    sum[p][k] += threads[t].totals[p][k];
+        }
+        if (!available[0]) {
+            out << "Performance counters unavailable: " << error << endl;
+            return;
+        }
+        uint64_t clock = 0;
+        for (size_t p = 0; p < PHASES; ++p) clock += sum[p][0];
+
+        stringstream table;
+        table << left << setw(8) << "phase" << right << setw(8) << "time%";
+        for (size_t k = 0; k < PERF_EVENTS; ++k)
+            table << setw(16) << PERF_EVENT_LIST[k].name;
+        table << setw(8) << "IPC" << "\n";
+        for (size_t p = 0; p < PHASES; ++p) {
+            table << left << setw(8) << PHASE_NAMES[p] << right << setw(8)
+                  << fixed << setprecision(1)
+                  << (clock > 0 ? 100.0 * static_cast<double>(sum[p][0]) /
+                                      static_cast<double>(clock)
+                                : 0);
+            for (size_t k = 0; k < PERF_EVENTS; ++k) {
+                if (available[k])
+                    table << setw(16) << sum[p][k];
+                else
+                    table << setw(16) << "n/a";
+            }
+            if (available[1] && available[2] && sum[p][1] > 0)
+                table << setw(8) << setprecision(2)
+                      << static_cast<double>(sum[p][2]) /
+                             static_cast<double>(sum[p][1]);
+            else
+                table << setw(8) << "n/a";
+            table << "\n";
+        }
+        out << table.str() << flush;
+    }
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stats.h"
+
+using namespace std;
+
+// Reports the progress of IC() periodically on stderr and/or by rewriting a
+// JSON stats file, from the per-thread counters of stats.h
+class Progress {
+   private:
+    using Clock = chrono::steady_clock;
+
+    // The parallel loops over the seed matroids of IC(r, n), which the
+    // recursion may run several times
+    struct Level {
+        uint16_t r;
+        uint16_t n;
+        size_t total = 0;  // seeds to process
+        uint64_t seeds = 0;  // of the finished loops
+        uint64_t extensions = 0;
+        double seconds = 0;
+        bool active = false;  // a loop is running, started at:
+        uint64_t seeds_base = 0;  // counter sums
+        uint64_t extensions_base = 0;
+        Clock::time_point start;
+    };
+
+    struct Totals {
+        uint64_t seeds = 0;
+        uint64_t extensions = 0;
+        uint64_t nodes = 0;
+        uint64_t checks = 0;
+        uint64_t rejections = 0;
+        uint64_t early_checks = 0;
+        uint64_t early_cuts = 0;
+    };
+
+    vector<ThreadStats> threads;
+    vector<Level> levels;  // in the order of their first loop
+    size_t current = 0;    // index of the last started level
+    mutex levels_mutex;
+    bool to_stderr;
+    string filename;
+    chrono::seconds interval;
+    Clock::time_point start;
+
+    thread reporter;
+    mutex stop_mutex;
+    condition_variable stop_cv;
+    bool stop = false;
+
+    static double seconds_since(Clock::time_point t) {
+        return chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    Totals totals() const {
+        Totals t;
+        for (const ThreadStats& s : threads) {
+            t.seeds += s.seeds.load(memory_order_relaxed);
+            t.extensions += s.extensions.load(memory_order_relaxed);
+            t.nodes += s.nodes.load(memory_order_relaxed);
+            t.checks += s.checks.load(memory_order_relaxed);
+            t.rejections += s.rejections.load(memory_order_relaxed);
+            t.early_checks += s.early_checks.load(memory_order_relaxed);
+            t.early_cuts += s.early_cuts.load(memory_order_relaxed);
+        }
+        return t;
+    }
+
+    // Seeds and extensions of a level so far, and its duration
+    static void level_progress(const Level& level, const Totals& t,
+                               uint64_t& seeds, uint64_t& extensions,
+                               double& seconds) {
+        seeds = level.seeds;
+        extensions = level.extensions;
+        seconds = level.seconds;
+        if (level.active) {
+            seeds += t.seeds - level.seeds_base;
+            extensions += t.extensions - level.extensions_base;
+            seconds += seconds_since(level.start);
+        }
+    }
+
+    // Estimated remaining seconds of a level, or -1 if unknown
+    static double eta(uint64_t seeds, size_t total, double seconds) {
+        if (seeds == 0) return -1;
+        uint64_t remaining = total - min<uint64_t>(seeds, total);
+        return seconds / static_cast<double>(seeds) *
+               static_cast<double>(remaining);
+    }
+
+    void report() {
+        lock_guard<mutex> lock(levels_mutex);
+        Totals t = totals();
+        double elapsed = seconds_since(start);
+
+        if (to_stderr && current < levels.size()) {
+            const Level& level = levels[current];
+            uint64_t seeds, extensions;
+            double seconds;
+            level_progress(level, t, seeds, extensions, seconds);
+            double busy = 0;
+            for (const ThreadStats& s : threads)
+                busy += static_cast<double>(s.busy_ns.load()) * 1e-9;
+            double capacity = elapsed * static_cast<double>(threads.size());
+            stringstream line;
+            line << fixed << setprecision(1) << "[" << elapsed << "s] ("
+                 << level.r << ", " << level.n << "): seeds " << seeds << "/"
+                 << level.total << ", " << extensions << " extensions ("
+                 << (seconds > 0 ? static_cast<double>(extensions) / seconds
+                                 : 0)
+                 << "/s), " << t.nodes << " nodes, " << t.checks
+                 << " checks (" << t.rejections << " rejected), busy "
+                 << (capacity > 0 ? 100 * busy / capacity : 0) << "%";
+            double e = eta(seeds, level.total, seconds);
+            if (level.active && e >= 0) line << ", ETA " << e << "s";
+            cerr << line.str() << endl;
+        }
+
+        if (!filename.empty()) {
+            string tmp_filename = filename + ".tmp";
+            ofstream out(tmp_filename);
+            write_json(out, t, elapsed);
+            out.close();
+            filesystem::rename(tmp_filename, filename);
+        }
+    }
+
+    void write_json(ostream& out, const Totals& t, double elapsed) const {
+        out << fixed << setprecision(3) << "{\n"
+            << "  \"elapsed\": " << elapsed << ",\n"
+            << "  \"extensions\": " << t.extensions << ",\n"
+            << "  \"nodes\": " << t.nodes << ",\n"
+            << "  \"checks\": " << t.checks << ",\n"
+            << "  \"rejections\": " << t.rejections << ",\n"
+            << "  \"early_checks\": " << t.early_checks << ",\n"
+            << "  \"early_cuts\": " << t.early_cuts << ",\n"
+            << "  \"levels\": [";
+        for (size_t i = 0; i < levels.size(); ++i) {
+            const Level& level = levels[i];
+            uint64_t seeds, extensions;
+            double seconds;
+            level_progress(level, t, seeds, extensions, seconds);
+            out << (i ? ",\n" : "\n") << "    {\"r\": " << level.r
+                << ", \"n\": " << level.n << ", \"seeds\": " << seeds
+                << ", \"total\": " << level.total
+                << ", \"extensions\": " << extensions
+                << ", \"seconds\": " << seconds
+                << ", \"eta\": "
+                << (level.active ? eta(seeds, level.total, seconds) : 0)
+                << "}";
+        }
+        out << "\n  ],\n  \"threads\": [";
+        for (size_t i = 0; i < threads.size(); ++i) {
+            const ThreadStats& s = threads[i];
+            out << (i ? ",\n" : "\n") << "    {\"seeds\": "
+                << s.seeds.load(memory_order_relaxed)
+                << ", \"busy\": "
+                << static_cast<double>(s.busy_ns.load()) * 1e-9
+                << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+   public:
+    Progress(int num_threads, bool to_stderr, const string& filename,
+             chrono::seconds interval)
+        : threads(num_threads),
+          to_stderr(to_stderr),
+          filename(filename),
+          interval(interval),
+          start(Clock::now()) {
+        reporter = thread([this] {
+            unique_lock<mutex> lock(stop_mutex);
+            while (!stop_cv.wait_for(lock, this->interval,
+                                     [this] { return stop; })) {
+                report();
+            }
+        });
+    }
+
+    // Collect the counters of the calling thread (thread number tid)
+    void attach(int tid) { thread_stats = &threads[tid]; }
+
+    // Called before the seeds of IC(r, n) are processed, outside of parallel
+    // regions
+    void begin_level(uint16_t r, uint16_t n, size_t total) {
+        lock_guard<mutex> lock(levels_mutex);
+        for (current = 0; current < levels.size(); ++current)
+            if (levels[current].r == r && levels[current].n == n) break;
+        if (current == levels.size()) {
+            levels.emplace_back();
+            levels.back().r = r;
+            levels.back().n = n;
+        }
+        Level& level = levels[current];
+        Totals t = totals();
+        level.total += total;
+        level.active = true;
+        level.seeds_base = t.seeds;
+        level.extensions_base = t.extensions;
+        level.start = Clock::now();
+    }
+
+    void end_level() {
+        lock_guard<mutex> lock(levels_mutex);
+        Level& level = levels[current];
+        level_progress(level, totals(), level.seeds, level.extensions,
+                       level.seconds);
+        level.active = false;
+    }
+
+    ~Progress() {
+        if (reporter.joinable()) finish();
+    }
+
+    // Stop the reporter and report the final counts
+    void finish() {
+        {
+            lock_guard<mutex> lock(stop_mutex);
+            stop = true;
+        }
+        stop_cv.notify_one();
+        reporter.join();
+        report();
+    }
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "combinatorics.h"
+
+using namespace std;
+
+// Cheap matroid invariants, computed from the ranks of all subsets
+struct Properties {
+    bool loopless;
+    bool coloopless;
+    bool simple;
+    bool connected;
+    bool paving;
+    int64_t T20;  // Tutte polynomial evaluations T(2, 0), T(0, 2), T(1, 1)
+    int64_t T02;
+    int64_t T11;
+    int64_t beta_invariant;
+};
+
+// Ranks of all subsets of [n] (as bitmasks) of the matroid given by colex,
+// where sets[i] is the i-th r-set in colex order
+inline void rank_table(uint16_t n, const string& colex,
+                       const vector<bitset<N>>& sets, vector<uint8_t>& rank) {
+    const size_t full = (size_t(1) << n) - 1;
+    rank.assign(full + 1, 0);
+
+    // Mark independent sets (subsets of bases), top-down
+    for (size_t i = 0; i < colex.size(); ++i) {
+        if (colex[i] == '*') rank[sets[i].to_ulong()] = 1;
+    }
+    for (size_t X = full + 1; X-- > 0;) {
+        if (!rank[X]) continue;
+        for (size_t Y = X; Y; Y &= Y - 1) {
+            rank[X & ~(Y & -Y)] = 1;
+        }
+    }
+
+    // r(X) = |X| if X is independent, max_{e in X} r(X - e) otherwise
+    for (size_t X = 0; X <= full; ++X) {
+        if (rank[X]) {
+            rank[X] = static_cast<uint8_t>(bitset<N>(X).count());
+            continue;
+        }
+        for (size_t Y = X; Y; Y &= Y - 1) {
+            rank[X] = max(rank[X], rank[X & ~(Y & -Y)]);
+        }
+    }
+}
+
+inline Properties compute_properties(uint16_t r, uint16_t n,
+                                     const string& colex,
+                                     const vector<bitset<N>>& sets,
+                                     vector<uint8_t>& rank) {
+    rank_table(n, colex, sets, rank);
+    const size_t full = (size_t(1) << n) - 1;
+
+    Properties p{true, true, true, true, true, 0, 0, 0, 0};
+    for (uint16_t e = 0; e < n; ++e) {
+        if (rank[size_t(1) << e] == 0) p.loopless = false;
+        if (rank[full & ~(size_t(1) << e)] < r) p.coloopless = false;
+    }
+
+    p.simple = p.loopless;
+    for (uint16_t e = 0; e < n && p.simple; ++e) {
+        for (uint16_t g = e + 1; g < n; ++g) {
+            if (rank[(size_t(1) << e) | (size_t(1) << g)] < 2) {
+                p.simple = false;
+                break;
+            }
+        }
+    }
+
+    // Every set of r - 1 elements is independent
+    for (size_t X = 0; X <= full && r > 0; ++X) {
+        if (bitset<N>(X).count() + 1 == r && rank[X] + 1 < r) {
+            p.paving = false;
+            break;
+        }
+    }
+
+    // No separator: r(X) + r(E - X) = r for some nonempty proper subset X
+    // (it suffices to consider X containing the element 0)
+    for (size_t X = 1; X < full; X += 2) {
+        if (rank[X] + rank[full & ~X] == r) {
+            p.connected = false;
+            break;
+        }
+    }
+
+    // T(x, y) = sum_X (x - 1)^(r - r(X)) (y - 1)^(|X| - r(X))
+    // beta = (-1)^r sum_X (-1)^|X| r(X)
+    for (size_t X = 0; X <= full; ++X) {
+        size_t size = bitset<N>(X).count();
+        size_t corank = r - rank[X];
+        size_t nullity = size - rank[X];
+        p.T20 += (nullity % 2) ? -1 : 1;
+        p.T02 += (corank % 2) ? -1 : 1;
+        p.T11 += (corank == 0 && nullity == 0);
+        p.beta_invariant += (size % 2) ? -rank[X] : rank[X];
+    }
+    if (r % 2) p.beta_invariant = -p.beta_invariant;
+
+    return p;
+}
+
+// Output the properties as a JSON object (formatted as by Python's json.dump
+// with indent=2, at the given depth)
+inline void write_properties_json(ostream& out, const Properties& p,
+                                  int depth) {
+    string pad(2 * depth, ' ');
+    auto b = [](bool v) { return v ? "true" : "false"; };
+    out << "{\n"
+        << pad << "  \"loopless\": " << b(p.loopless) << ",\n"
+        << pad << "  \"coloopless\": " << b(p.coloopless) << ",\n"
+        << pad << "  \"simple\": " << b(p.simple) << ",\n"
+        << pad << "  \"connected\": " << b(p.connected) << ",\n"
+        << pad << "  \"paving\": " << b(p.paving) << ",\n"
+        << pad << "  \"T20\": " << p.T20 << ",\n"
+        << pad << "  \"T02\": " << p.T02 << ",\n"
+        << pad << "  \"T11\": " << p.T11 << ",\n"
+        << pad << "  \"beta_invariant\": " << p.beta_invariant << "\n"
+        << pad << "}";
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "extension.h"
+#include "matroid.h"
+
+using namespace std;
+
+// The number of linear subclasses, and hence the time to extend a seed, grows
+// roughly exponentially in the number of hyperplanes left free after removing
+// the taboo ones: log(seconds) grows by about 0.1 per free hyperplane for the
+// (4, 8) seeds of IC(4, 9). Fit again with --cost-report.
+constexpr double COST_GROWTH = 0.1;
+
+// Cheap features of a seed matroid, from the same initialization as
+// traverse_linear_subclasses
+struct SeedCost {
+    size_t hyperplanes = 0;
+    size_t hyperlines = 0;
+    size_t taboo = 0;
+    size_t free_planes = 0;  // after removing the taboo hyperplanes
+    size_t branches = 0;     // of the canonicity test left open by the seed
+    size_t automorphisms = 0;
+    double predicted = 0;    // relative cost
+    double measured = 0;     // seconds
+};
+
+// The canonicity branches and automorphisms are only reported, not predicted
+// from, so they are computed for the cost report only
+inline SeedCost estimate_cost(const Matroid& M, bool report) {
+    M.init_ind_sets_rm1();
+    M.init_hyperplanes();
+    M.init_hyperlines();
+    M.init_taboo_hyperplanes();
+    Node node(&M);
+    for (const bitset<N>& T : M.taboo_hyperplanes)
+        node.remove_plane(M.hyperplanes_index[T]);
+
+    SeedCost c;
+    c.hyperplanes = M.hyperplanes.size();
+    c.hyperlines = M.hyperlines.size();
+    c.taboo = M.taboo_hyperplanes.size();
+    c.free_planes = node.p_free.count();
+    if (report) {
+        PrefixBranches B;
+        init_prefix_branches(M, B);
+        c.branches = B.branches.size();
+        c.automorphisms = B.automorphisms;
+    }
+    c.predicted = exp(COST_GROWTH * static_cast<double>(c.free_planes));
+    return c;
+}
+
+// Order of the given seed indices by decreasing predicted cost (ties by
+// index), so that no expensive seed is left for the end of the run
+inline vector<size_t> longest_first(const vector<size_t>& seeds,
+                                    const vector<SeedCost>& costs) {
+    vector<size_t> order = seeds;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return costs[a].predicted > costs[b].predicted;
+    });
+    return order;
+}
+
+// Output one line per seed "index hyperplanes hyperlines taboo free_planes
+// branches automorphisms predicted measured" and summarize on stderr how well
+// log(predicted) fits log(measured), with the least-squares growth per free
+// hyperplane
+inline void write_cost_report(const string& filename,
+                              const vector<size_t>& seeds,
+                              const vector<SeedCost>& costs) {
+    ofstream out(filename);
+    out << "# index hyperplanes hyperlines taboo free_planes branches "
+           "automorphisms predicted measured\n";
+    vector<double> x, y, p;
+    for (size_t i : seeds) {
+        const SeedCost& c = costs[i];
+        out << i << " " << c.hyperplanes << " " << c.hyperlines << " "
+            << c.taboo << " " << c.free_planes << " " << c.branches << " "
+            << c.automorphisms << " " << c.predicted << " " << c.measured
+            << "\n";
+        if (c.measured <= 0) continue;
+        x.push_back(static_cast<double>(c.free_planes));
+        y.push_back(log(c.measured));
+        p.push_back(log(c.predicted));
+    }
+    out.close();
+    if (x.size() < 2) return;
+
+    double m = static_cast<double>(x.size());
+    double mx = accumulate(x.begin(), x.end(), 0.0) / m;
+    double my = accumulate(y.begin(), y.end(), 0.0) / m;
+    double mp = accumulate(p.begin(), p.end(), 0.0) / m;
+    double sxy = 0, sxx = 0, spy = 0, spp = 0, syy = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        sxy += (x[i] - mx) * (y[i] - my);
+        sxx += (x[i] - mx) * (x[i] - mx);
+        spy += (p[i] - mp) * (y[i] - my);
+        spp += (p[i] - mp) * (p[i] - mp);
+        syy += (y[i] - my) * (y[i] - my);
+    }
+    cerr << "Cost model over " << x.size() << " seeds: correlation "
+         << (spp > 0 && syy > 0 ? spy / sqrt(spp * syy) : 0)
+         << " of log(predicted) and log(measured), fitted growth "
+         << (sxx > 0 ? sxy / sxx : 0) << " per free hyperplane (COST_GROWTH "
+         << COST_GROWTH << ")" << endl;
+}
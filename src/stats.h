@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Counters of one thread. Each counter has a single writer, so increments are
+// plain loads and stores; the atomics only make concurrent reads well-defined.
+struct alignas(64) ThreadStats {
+    atomic<uint64_t> seeds{0};       // seed matroids processed
+    atomic<uint64_t> extensions{0};  // canonical extensions emitted
+    atomic<uint64_t> nodes{0};       // DFS nodes visited
+    atomic<uint64_t> checks{0};      // canonicity checks
+    atomic<uint64_t> rejections{0};  // of which not canonical
+    atomic<uint64_t> early_checks{0};  // canonicity tests at internal nodes
+    atomic<uint64_t> early_cuts{0};    // of which cut the subtree
+    atomic<uint64_t> busy_ns{0};     // time spent processing seeds
+};
+
+// Counters of the current thread, or nullptr if not collected
+inline thread_local ThreadStats* thread_stats = nullptr;
+
+inline void bump(atomic<uint64_t>& counter, uint64_t value = 1) {
+    counter.store(counter.load(memory_order_relaxed) + value,
+                  memory_order_relaxed);
+}
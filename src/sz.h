@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <fstream>
+#include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,12 +20,12 @@ static inline int bits_for(size_t max_val) {
 }
 
 struct BitWriter {
-    ofstream* f;
+    ostream* f;
     uint8_t buf;
     int bit_pos;
 };
 
-static inline void bw_init(BitWriter* bw, ofstream* f) {
+static inline void bw_init(BitWriter* bw, ostream* f) {
     bw->f = f;
     bw->buf = 0;
     bw->bit_pos = 7;
@@ -32,7 +34,7 @@ static inline void bw_init(BitWriter* bw, ofstream* f) {
 static inline void bw_write_bit(BitWriter* bw, int bit) {
     if (bit) bw->buf |= (1u << bw->bit_pos);
     if (bw->bit_pos-- == 0) {
-        bw->f->write(reinterpret_cast<char*>(&bw->buf), 1);
+        bw->f->put(static_cast<char>(bw->buf));
         bw->buf = 0;
         bw->bit_pos = 7;
     }
@@ -43,7 +45,7 @@ static inline void bw_write_bits(BitWriter* bw, uint32_t val, int n) {
 }
 
 static inline void bw_flush(BitWriter* bw) {
-    if (bw->bit_pos < 7) bw->f->write(reinterpret_cast<char*>(&bw->buf), 1);
+    if (bw->bit_pos < 7) bw->f->put(static_cast<char>(bw->buf));
 }
 
 struct BitReader {
@@ -81,7 +83,9 @@ static inline int br_read_bits(BitReader* br, int n, uint32_t* out) {
 // Streaming compressor for bitstrings ('0'/'*' encoding 0/1)
 class SZWriter {
    private:
-    ofstream file;
+    filebuf file_buf;
+    unique_ptr<streambuf> custom_buf;  // e.g. asynchronous output
+    ostream file{nullptr};
     BitWriter bw;
     size_t line_len;
     int B;
@@ -97,11 +101,21 @@ class SZWriter {
     bool open(const string& filename, bool streaming = false) {
         this->streaming = streaming;
         if (filename == "-")
-            file.open("/dev/stdout", ios::binary);
+            file_buf.open("/dev/stdout", ios::out | ios::binary);
         else
-            file.open(filename, ios::binary);
-        if (!file.is_open()) return false;
+            file_buf.open(filename, ios::out | ios::binary);
+        if (!file_buf.is_open()) return false;
 
+        file.rdbuf(&file_buf);
+        return true;
+    }
+
+    // Write to the given output buffer instead of a file
+    bool open(unique_ptr<streambuf> buf, bool streaming = false) {
+        this->streaming = streaming;
+        if (!buf) return false;
+        custom_buf = move(buf);
+        file.rdbuf(custom_buf.get());
         return true;
     }
 
@@ -142,7 +156,18 @@ class SZWriter {
         count++;
     }
 
+    // Write all lines so far to the file. A partial last byte is written and
+    // overwritten once complete, so the file stays decodable without a count.
+    void flush() {
+        if (!first_line && bw.bit_pos < 7) {
+            bw_flush(&bw);
+            file.seekp(-1, ios::cur);
+        }
+        file.flush();
+    }
+
     void close() {
+        if (!file.rdbuf()) return;
         if (!first_line) {
             bw_flush(&bw);
         }
@@ -151,7 +176,10 @@ class SZWriter {
             file.seekp(sizeof(uint32_t), ios::beg);
             file.write(reinterpret_cast<const char*>(&count), sizeof(count));
         }
-        file.close();
+        file.flush();
+        file.rdbuf(nullptr);
+        file_buf.close();
+        custom_buf.reset();
     }
 
     ~SZWriter() { close(); }
@@ -240,6 +268,8 @@ class SZReader {
 
     size_t get_expected_count() const { return cnt; }
 
+    size_t get_line_len() const { return line_len; }
+
     string getinfo() {
         string noun = (cnt == 1) ? "string" : "strings";
         return to_string(cnt) + " " + noun + " of length " +
@@ -249,3 +279,35 @@ class SZReader {
     void close() { file.close(); }
     ~SZReader() { close(); }
 };
+
+// Reader for colex lines from either a .sz file or a plain text file/stdin
+class ColexReader {
+   private:
+    unique_ptr<SZReader> sz_reader;
+    ifstream file;
+    istream* in = nullptr;
+
+   public:
+    bool open(const string& filename) {
+        if (filename.size() > 3 &&
+            filename.compare(filename.size() - 3, 3, ".sz") == 0) {
+            sz_reader = make_unique<SZReader>();
+            return sz_reader->open(filename);
+        }
+        if (filename == "-") {
+            in = &cin;
+            return true;
+        }
+        file.open(filename);
+        in = &file;
+        return file.is_open();
+    }
+
+    bool getline(string& line) {
+        if (sz_reader) return sz_reader->getline(line);
+        while (std::getline(*in, line)) {
+            if (!line.empty()) return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+#include "matroid.h"
+
+using namespace std;
+
+// Receives the matroids generated at the top level of IC() in place of the
+// regular output
+class Visitor {
+   public:
+    virtual ~Visitor() = default;
+
+    // Called concurrently from the OpenMP threads (tid: thread number) with
+    // the index of the seed matroid M was generated from
+    virtual void visit(const Matroid& M, size_t index, int tid) = 0;
+
+    // Called once after the enumeration, e.g. to reduce per-thread state
+    virtual void finish() {}
+};
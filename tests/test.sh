@@ -15,6 +15,30 @@ if [ ! -f $extend_executable ]; then
     exit 1
 fi
 
+canonicalize_executable="../build/IC-canonicalize"
+if [ ! -f $canonicalize_executable ]; then
+    echo "Error: IC-canonicalize executable not found"
+    exit 1
+fi
+
+minors_executable="../build/IC-minors"
+if [ ! -f $minors_executable ]; then
+    echo "Error: IC-minors executable not found"
+    exit 1
+fi
+
+props_executable="../build/IC-props"
+if [ ! -f $props_executable ]; then
+    echo "Error: IC-props executable not found"
+    exit 1
+fi
+
+verify_executable="../build/IC-verify"
+if [ ! -f $verify_executable ]; then
+    echo "Error: IC-verify executable not found"
+    exit 1
+fi
+
 flag=true
 extension_output=$($extend_executable 2 4 "******")
 expected_extensions=$'**********\n0000******'
@@ -23,6 +47,19 @@ if [ "$extension_output" != "$expected_extensions" ]; then
     flag=false
 fi
 
+batch_output=$(printf '******\n0*****\n' | $extend_executable 2 4 --batch - 2)
+expected_batch=$'0 **********\n0 0000******\n1 0*********\n1 00000*****'
+if [ "$batch_output" != "$expected_batch" ]; then
+    echo "Test failed: IC-extend --batch (2, 4)"
+    flag=false
+fi
+
+canonical_output=$(echo "*****0" | $canonicalize_executable 2 4)
+if [ "$canonical_output" != "0***** 2,3,0,1" ]; then
+    echo "Test failed: IC-canonicalize (2, 4, *****0)"
+    flag=false
+fi
+
 N=8
 echo "Testing for all matroids with up to $N elements..."
 for ((r = 0; r <= N; r++)); do
@@ -53,6 +90,260 @@ for ((r = 0; r <= N; r++)); do
     done
 done
 
+# Sharded run, merged into the output of a single run
+for i in 0 1 2; do
+    $executable 4 8 2 --compressed-file --shard $i/3
+done
+$executable 4 8 --compressed-file --merge-shards 3
+output=$(../scripts/szcat.sh "output/r04n08.sz")
+if [ "$(< expected/r04n08)" != "$output" ]; then
+    echo "Test failed: (4, 8, --shard i/3, --merge-shards 3)"
+    flag=false
+fi
+$executable 4 8 --file --shard x/3 >/dev/null
+if [ $? -ne 1 ]; then
+    echo "Test failed: (4, 8, --shard x/3) is not rejected"
+    flag=false
+fi
+
+# Longest-first scheduling, merged back into index order
+$executable 4 8 3 --compressed-file --longest-first
+output=$(../scripts/szcat.sh "output/r04n08.sz")
+if [ "$(< expected/r04n08)" != "$output" ]; then
+    echo "Test failed: (4, 8, 3, --compressed-file --longest-first)"
+    flag=false
+fi
+
+# High rank as the duals of the (3, 8) matroids
+output=$($executable 5 8 2 --via-dual)
+if [ "$(< expected/r05n08)" != "$output" ]; then
+    echo "Test failed: (5, 8, 2, --via-dual)"
+    flag=false
+fi
+
+# A truncated (3, 8) file is not read but generated again
+$executable 3 8 --compressed-file 2>/dev/null
+head -c 100 output/r03n08.sz >output/truncated.sz
+mv output/truncated.sz output/r03n08.sz
+output=$($executable 5 8 2 --via-dual 2>/dev/null)
+if [ "$(< expected/r05n08)" != "$output" ]; then
+    echo "Test failed: (5, 8, 2, --via-dual) with a truncated (3, 8) file"
+    flag=false
+fi
+rm -f output/r03n08.sz
+
+# NUMA-aware mode (per-node tables and seed queues) gives the same file
+rm -f output/r04n08
+$executable 4 8 2 --numa --huge-pages --file 2>/dev/null
+if [ "$(< expected/r04n08)" != "$(< output/r04n08)" ]; then
+    echo "Test failed: (4, 8, 2, --numa)"
+    flag=false
+fi
+
+# Per-phase counters on stderr (the task clock needs no hardware counters)
+output=$($executable 4 8 --perf-counters 2>&1 >/dev/null)
+if ! grep -qE '^check|unavailable' <<< "$output"; then
+    echo "Test failed: (4, 8, --perf-counters)"
+    flag=false
+fi
+
+# Estimate: the seeds of (4, 8) are small enough to be extended exactly
+output=$($executable 4 8 2 --estimate)
+if ! grep -q '"matroids": 940,' <<< "$output"; then
+    echo "Test failed: (4, 8, 2, --estimate)"
+    flag=false
+fi
+
+# Binary output: all records, and the records of seed 1 by the seed table
+$executable 4 8 2 --binary
+output=$(../build/bincat output/r04n08.bin)
+seed_output=$(../build/bincat output/r04n08.bin -s 1)
+if [ "$(< expected/r04n08)" != "$output" ] ||
+    [ "$(sed -n 2,3p expected/r04n08)" != "$seed_output" ]; then
+    echo "Test failed: (4, 8, 2, --binary)"
+    flag=false
+fi
+
+# Asynchronous output with a single pending request, synced after each seed
+$executable 4 8 3 --compressed-file --async-io --io-depth 1 --checkpoint 0
+output=$(../scripts/szcat.sh "output/r04n08.sz")
+if [ "$(< expected/r04n08)" != "$output" ]; then
+    echo "Test failed: (4, 8, 3, --compressed-file --async-io)"
+    flag=false
+fi
+# A thread file that cannot be created stops the run
+mkdir output/r04n08-thread00
+if $executable 4 8 --file --async-io 2>/dev/null; then
+    echo "Test failed: (4, 8, --file --async-io) without its thread file"
+    flag=false
+fi
+rmdir output/r04n08-thread00
+rm -f output/r04n08-thread0*.idx
+
+# Seeds with the flats derived from their parents
+output=$($executable 4 8 --carry-flats)
+if [ "$(< expected/r04n08)" != "$output" ]; then
+    echo "Test failed: (4, 8, --carry-flats)"
+    flag=false
+fi
+
+# Binary and ternary matroids, by their excluded minors
+binary=$($executable 4 8 --exclude-minors ../scripts/minors/binary.txt | grep -c '')
+ternary=$($executable 4 8 2 --exclude-minors ../scripts/minors/ternary.txt | grep -c '')
+if [ "$binary" != 106 ] || [ "$ternary" != 238 ]; then
+    echo "Test failed: (4, 8, --exclude-minors)"
+    flag=false
+fi
+
+# Cost report: the uniform seed U(4, 7) has all 7! permutations as
+# automorphisms
+$executable 4 8 --cost-report output/costs.txt >/dev/null 2>&1
+if [ "$(sed -n 2p output/costs.txt | cut -d' ' -f1,7)" != "0 5040" ]; then
+    echo "Test failed: (4, 8, --cost-report)"
+    flag=false
+fi
+
+# Resumed run: shard 0 poses as the thread file of an interrupted run, with an
+# .idx entry whose lines are missing and a torn last entry
+mv output/r04n08-shard00of03.sz output/r04n08-thread00.sz
+mv output/r04n08-shard00of03.idx output/r04n08-thread00.idx
+printf '1 1000\n2' >>output/r04n08-thread00.idx
+$executable 4 8 2 --compressed-file --resume 2>/dev/null
+output=$(../scripts/szcat.sh "output/r04n08.sz")
+if [ "$(< expected/r04n08)" != "$output" ]; then
+    echo "Test failed: (4, 8, --resume)"
+    flag=false
+fi
+
+# A resume with other scheduling options, whose thread files would be plain
+# text, is rejected
+touch output/r04n08-thread00.sz output/r04n08-thread00.idx
+if $executable 4 8 --compressed-file --longest-first --resume 2>/dev/null; then
+    echo "Test failed: (4, 8, --resume) with other options"
+    flag=false
+fi
+rm -f output/r04n08-thread00.sz output/r04n08-thread00.idx
+
+# Generation through the shared library (if Python is available)
+if command -v python3 >/dev/null; then
+    output=$(python3 ../scripts/libmatroid.py 4 8 2)
+    if [ "$(< expected/r04n08)" != "$output" ]; then
+        echo "Test failed: libmatroid (4, 8)"
+        flag=false
+    fi
+    # The same engine as IC, also with its restrictions
+    output=$(PYTHONPATH=../scripts python3 -c "import libmatroid
+print('\n'.join(libmatroid.generate(4, 8, 2, simple=True,
+      exclude_minors='../scripts/minors/binary.txt')))")
+    if [ "$($executable 4 8 --simple --exclude-minors \
+        ../scripts/minors/binary.txt)" != "$output" ]; then
+        echo "Test failed: libmatroid (4, 8, --simple --exclude-minors)"
+        flag=false
+    fi
+fi
+
+# Minor indices of (2, 4) matroids, using the .sz outputs from above
+$minors_executable 2 4 >/dev/null
+minors_output=$(od -An -tu4 -w8 output/r02n04-minors.bin | tr -s ' ' | paste -sd';')
+expected_minors=" 7 0; 0 0; 1 0; 1 1; 2 1; 4294967295 0; 4294967295 1; 4294967295 2"
+if [ "$minors_output" != "$expected_minors" ]; then
+    echo "Test failed: IC-minors (2, 4)"
+    flag=false
+fi
+
+# Invariant counts of (4, 8) matroids
+$props_executable 4 8 2
+props_output=$(tr -d ' \n' < output/r04n08-invariants-counts.json)
+expected_props='{"all":940,"loopless":832,"coloopless":832,"simple":617,"connected":731,"paving":322}'
+if [ "$props_output" != "$expected_props" ]; then
+    echo "Test failed: IC-props (4, 8)"
+    flag=false
+fi
+
+# Verification of the (4, 8) archive, and of a non-canonical one
+echo "*****0" > output/bad
+../build/sz output/bad -o output/bad.sz >/dev/null
+if ! $verify_executable 4 8 2 >/dev/null ||
+    [ "$($verify_executable 2 4 1 output/bad.sz 2>&1)" != \
+        "output/bad.sz: line 1: not canonical (fails at position 0)" ]; then
+    echo "Test failed: IC-verify (4, 8)"
+    flag=false
+fi
+
+# Benchmark driver: results with scaling efficiency, and a baseline check
+if ! python3 ../scripts/benchmark.py --matrix 3,7 --threads 1 --repeat 1 \
+    --modes stdout --save-baseline >/dev/null 2>&1 ||
+    ! python3 ../scripts/benchmark.py --matrix 3,7 --threads 1 --repeat 1 \
+        --modes stdout --tolerance 100 >/dev/null 2>&1 ||
+    ! grep -q '"matroids": 108,' output/benchmark.json ||
+    ! grep -q '"efficiency": 1.0' output/benchmark.json; then
+    echo "Test failed: benchmark.py (3, 7)"
+    flag=false
+fi
+
+# A baseline 100 times as fast, or of another host, fails the check
+benchmark="python3 ../scripts/benchmark.py --matrix 3,7 --threads 1 --repeat 1
+    --modes stdout --baseline output/doctored.json"
+python3 -c "import json
+report = json.load(open('output/benchmark-baseline.json'))
+for res in report['results']:
+    res['wall_seconds'] /= 100
+json.dump(report, open('output/doctored.json', 'w'))"
+if $benchmark >/dev/null 2>&1; then
+    echo "Test failed: benchmark.py with a faster baseline"
+    flag=false
+fi
+python3 -c "import json
+report = json.load(open('output/benchmark-baseline.json'))
+report['host'] += '-other'
+json.dump(report, open('output/doctored.json', 'w'))"
+if $benchmark --tolerance 100 >/dev/null 2>&1 ||
+    ! $benchmark --tolerance 100 --any-host >/dev/null 2>&1; then
+    echo "Test failed: benchmark.py with a baseline of another host"
+    flag=false
+fi
+rm -f output/doctored.json
+
+# Census of (4, 8) matroids without output files
+census_output=$($executable 4 8 2 --census | head -n 7 | tr -d ' \n')
+if [ "$census_output" != "${expected_props%\}}," ]; then
+    echo "Test failed: (4, 8, 2, --census)"
+    flag=false
+fi
+
+# Restricted generation: as many matroids as simple or paving ones above
+simple_output=$($executable 4 8 2 --census --simple | grep '"all"')
+paving_output=$($executable 4 8 2 --census --paving | grep '"all"')
+if [ "$simple_output" != '  "all": 617,' ] ||
+    [ "$paving_output" != '  "all": 322,' ]; then
+    echo "Test failed: (4, 8, 2, --census --simple/--paving)"
+    flag=false
+fi
+
+# Final stats of a (4, 8) run: all seeds of the top level done
+$executable 4 8 2 --stats-file output/stats.json >/dev/null
+if ! grep -q '"r": 4, "n": 8, "seeds": 109, "total": 109, "extensions": 940,' \
+    output/stats.json; then
+    echo "Test failed: (4, 8, 2, --stats-file)"
+    flag=false
+fi
+$executable 4 8 2 --paving --stats-file output/stats.json >/dev/null
+if ! grep -q '"r": 4, "n": 8, .*"extensions": 322,' output/stats.json; then
+    echo "Test failed: (4, 8, 2, --paving --stats-file)"
+    flag=false
+fi
+
+# Early pruning only saves canonicity checks of leaves
+$executable 4 8 --no-early-pruning --stats-file output/stats.json >/dev/null
+unpruned_checks=$(grep '"checks"' output/stats.json)
+$executable 4 8 --stats-file output/stats.json >/dev/null
+checks=$(grep '"checks"' output/stats.json)
+if ! grep -q '"r": 4, "n": 8, "seeds": 109, "total": 109, "extensions": 940,' \
+    output/stats.json || [ "$checks" == "$unpruned_checks" ]; then
+    echo "Test failed: (4, 8, --no-early-pruning)"
+    flag=false
+fi
+
 rm -rf output
 popd >/dev/null
 